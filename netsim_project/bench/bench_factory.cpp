@@ -0,0 +1,187 @@
+#include "factory.hpp"
+#include "factory_builder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Tury symulacji na fabrykach, których robotnicy zostali dodani w losowej kolejności,
+// przed i po `Factory::reorder_for_locality()`. Topologie: szeroka (kilka warstw po wielu robotników,
+// losowe połączenia między warstwami) i głęboka (wiele długich łańcuchów).
+// Chybienia w pamięci podręcznej liczone przez perf_event_open, jeśli system na to pozwala.
+
+namespace {
+
+    class CacheMissCounter {
+    public:
+        CacheMissCounter() {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd_ = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+        CacheMissCounter(const CacheMissCounter&) = delete;
+        CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+        ~CacheMissCounter() {
+            if (fd_ >= 0) {
+                close(fd_);
+            }
+        }
+
+        bool available() const { return fd_ >= 0; }
+
+        void start() {
+            if (available()) {
+                ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+
+        std::uint64_t stop() {
+            std::uint64_t count = 0;
+            if (available()) {
+                ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+                if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+                    count = 0;
+                }
+            }
+            return count;
+        }
+
+    private:
+        int fd_;
+    };
+
+    // Robotnicy trafiają do budowniczego w losowej kolejności -- tak jak w wygenerowanych układach.
+    void add_shuffled_workers(FactoryBuilder& builder, ElementID count, std::mt19937& rng) {
+        std::vector<WorkerRecord> workers;
+        workers.reserve(std::size_t(count));
+        for (ElementID id = 1; id <= count; ++id) {
+            workers.push_back({id, 2});
+        }
+        std::shuffle(workers.begin(), workers.end(), rng);
+        builder.add_workers(workers);
+    }
+
+    FactoryBuilder wide_topology(SimulationContext& context, ElementID layers, ElementID width) {
+        std::mt19937 rng(1);
+        FactoryBuilder builder(context);
+        add_shuffled_workers(builder, layers * width, rng);
+        auto in_layer = [&rng, width](ElementID layer) {
+            return layer * width + std::uniform_int_distribution<ElementID>(1, width)(rng);
+        };
+        for (ElementID r = 1; r <= width / 8; ++r) {
+            builder.add_ramp({r, 1});
+            for (int k = 0; k < 8; ++k) {
+                builder.add_link({ElementType::RAMP, r, ReceiverType::WORKER, in_layer(0)});
+            }
+        }
+        for (ElementID layer = 0; layer + 1 < layers; ++layer) {
+            for (ElementID i = 1; i <= width; ++i) {
+                builder.add_link({ElementType::WORKER, layer * width + i, ReceiverType::WORKER, in_layer(layer + 1)});
+                builder.add_link({ElementType::WORKER, layer * width + i, ReceiverType::WORKER, in_layer(layer + 1)});
+            }
+        }
+        for (ElementID s = 1; s <= 64; ++s) {
+            builder.add_storehouse({s});
+        }
+        for (ElementID i = 1; i <= width; ++i) {
+            builder.add_link({ElementType::WORKER, (layers - 1) * width + i, ReceiverType::STOREHOUSE, 1 + i % 64});
+        }
+        return builder;
+    }
+
+    FactoryBuilder deep_topology(SimulationContext& context, ElementID chains, ElementID length) {
+        std::mt19937 rng(2);
+        FactoryBuilder builder(context);
+        add_shuffled_workers(builder, chains * length, rng);
+        for (ElementID c = 0; c < chains; ++c) {
+            builder.add_ramp({c + 1, 1});
+            builder.add_storehouse({c + 1});
+            builder.add_link({ElementType::RAMP, c + 1, ReceiverType::WORKER, c * length + 1});
+            for (ElementID i = 1; i < length; ++i) {
+                builder.add_link({ElementType::WORKER, c * length + i, ReceiverType::WORKER, c * length + i + 1});
+            }
+            builder.add_link({ElementType::WORKER, (c + 1) * length, ReceiverType::STOREHOUSE, c + 1});
+        }
+        return builder;
+    }
+
+    struct Result {
+        double ns_per_turn;
+        std::uint64_t cache_misses;
+    };
+
+    Result run(Factory& factory, Time turns, CacheMissCounter& counter) {
+        auto graph = factory.compile();
+        // Rozgrzewka: kolejki i magazyny wypełniają się, zanim zacznie się pomiar.
+        for (Time t = 1; t <= turns; ++t) {
+            graph.do_deliveries(t);
+            graph.do_package_passing();
+            graph.do_work(t);
+        }
+
+        counter.start();
+        auto start = std::chrono::steady_clock::now();
+        for (Time t = turns + 1; t <= 2 * turns; ++t) {
+            graph.do_deliveries(t);
+            graph.do_package_passing();
+            graph.do_work(t);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        auto misses = counter.stop();
+
+        return {std::chrono::duration<double, std::nano>(stop - start).count() / double(turns), misses};
+    }
+
+    template <typename Make>
+    void compare(const std::string& name, Make make, Time turns, CacheMissCounter& counter) {
+        SimulationContext shuffled_context(42);
+        auto shuffled = make(shuffled_context).build();
+        auto before = run(shuffled, turns, counter);
+
+        SimulationContext ordered_context(42);
+        auto ordered = make(ordered_context).build();
+        ordered.reorder_for_locality();
+        auto after = run(ordered, turns, counter);
+
+        std::cout << name << std::endl;
+        std::cout << "  insertion order: " << before.ns_per_turn / 1000 << " us/turn";
+        if (counter.available()) {
+            std::cout << ", " << before.cache_misses / std::uint64_t(turns) << " cache misses/turn";
+        }
+        std::cout << std::endl << "  BFS order:       " << after.ns_per_turn / 1000 << " us/turn";
+        if (counter.available()) {
+            std::cout << ", " << after.cache_misses / std::uint64_t(turns) << " cache misses/turn";
+        }
+        std::cout << std::endl << "  speed-up:        " << before.ns_per_turn / after.ns_per_turn << "x" << std::endl;
+    }
+}
+
+int main() {
+    CacheMissCounter counter;
+    if (!counter.available()) {
+        std::cout << "perf_event_open unavailable -- reporting time only" << std::endl;
+    }
+
+    const Time turns = 50;
+    compare("wide: 4 layers x 50000 workers",
+            [](SimulationContext& context) { return wide_topology(context, 4, 50000); }, turns, counter);
+    compare("deep: 2000 chains x 100 workers",
+            [](SimulationContext& context) { return deep_topology(context, 2000, 100); }, turns, counter);
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "id_allocator.hpp"
+#include "package.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+// Porównanie przydziału ID: dawna para std::set (assigned/freed) kontra IdAllocator.
+// Scenariusz: n żywych ID, następnie rounds rund, w których zwalniana i ponownie
+// przydzielana jest losowa połowa z nich.
+
+namespace {
+
+    class SetIdAllocator {
+    public:
+        ElementID allocate() {
+            ElementID id;
+            if (freed_.empty()) {
+                id = assigned_.empty() ? 1 : *assigned_.rbegin() + 1;
+            } else {
+                id = *freed_.begin();
+                freed_.erase(id);
+            }
+            assigned_.insert(id);
+            return id;
+        }
+
+        void release(ElementID id) {
+            assigned_.erase(id);
+            freed_.insert(id);
+        }
+
+    private:
+        std::set<ElementID> assigned_;
+        std::set<ElementID> freed_;
+    };
+
+    template<typename Allocator>
+    double run(std::size_t n, int rounds) {
+        std::mt19937 rng(42);
+        Allocator ids;
+        std::vector<ElementID> live;
+        live.reserve(n);
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < n; ++i) {
+            live.push_back(ids.allocate());
+        }
+        for (int r = 0; r < rounds; ++r) {
+            std::shuffle(live.begin(), live.end(), rng);
+            for (std::size_t i = 0; i < n / 2; ++i) {
+                ids.release(live[i]);
+            }
+            for (std::size_t i = 0; i < n / 2; ++i) {
+                live[i] = ids.allocate();
+            }
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(stop - start).count();
+    }
+
+    double run_packages(std::size_t n, int rounds) {
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            std::vector<Package> live;
+            live.reserve(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                live.emplace_back();
+            }
+        }
+        auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(stop - start).count();
+    }
+}
+
+int main() {
+    const int rounds = 4;
+    std::cout << "live IDs      std::set [ms]   IdAllocator [ms]   speed-up" << std::endl;
+    for (std::size_t n : {1000U, 100000U, 1000000U}) {
+        double set_ms = run<SetIdAllocator>(n, rounds);
+        double bitmap_ms = run<IdAllocator>(n, rounds);
+        std::cout << n << "\t\t" << set_ms << "\t\t" << bitmap_ms << "\t\t" << set_ms / bitmap_ms << "x" << std::endl;
+    }
+
+    std::cout << std::endl << "Package() + ~Package(), 1M live, " << rounds << " rounds: "
+              << run_packages(1000000U, rounds) << " ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "package.hpp"
+#include "storage_types.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <memory>
+
+// Porównanie kolejki na buforze cyklicznym (`PackageQueue`) z dawną implementacją na std::list.
+// Dla każdej głębokości: napełnienie kolejki, seria operacji push+pop w stanie ustalonym, opróżnienie.
+
+namespace {
+
+    class ListPackageQueue {
+    public:
+        explicit ListPackageQueue(PackageQueueType queue_type) : queue_type_(queue_type) {}
+
+        void push(Package&& package) { queue_.emplace_back(std::move(package)); }
+
+        Package pop() {
+            if (queue_type_ == PackageQueueType::LIFO) {
+                Package package(std::move(queue_.back()));
+                queue_.pop_back();
+                return package;
+            }
+            Package package(std::move(queue_.front()));
+            queue_.pop_front();
+            return package;
+        }
+
+    private:
+        std::list<Package> queue_;
+        PackageQueueType queue_type_;
+    };
+
+    template<typename Queue>
+    double run(PackageQueueType type, std::size_t depth, std::size_t operations) {
+        Queue q(type);
+        long long checksum = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < depth; ++i) {
+            q.push(Package());
+        }
+        for (std::size_t i = 0; i < operations; ++i) {
+            Package p = q.pop();
+            checksum += p.get_id();
+            q.push(std::move(p));
+        }
+        for (std::size_t i = 0; i < depth; ++i) {
+            checksum += q.pop().get_id();
+        }
+        auto stop = std::chrono::steady_clock::now();
+
+        if (checksum == 0) {
+            std::cerr << "unexpected checksum" << std::endl;
+        }
+        double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        return ns / double(2 * depth + 2 * operations);
+    }
+}
+
+int main() {
+    const std::size_t operations = 2000000;
+    for (auto type : {PackageQueueType::FIFO, PackageQueueType::LIFO}) {
+        std::cout << (type == PackageQueueType::FIFO ? "FIFO" : "LIFO") << std::endl;
+        std::cout << "depth       std::list [ns/op]   ring [ns/op]   speed-up" << std::endl;
+        for (std::size_t depth = 1; depth <= 1000000; depth *= 10) {
+            double list_ns = run<ListPackageQueue>(type, depth, operations);
+            double ring_ns = run<PackageQueue>(type, depth, operations);
+            std::cout << depth << "\t\t" << list_ns << "\t\t" << ring_ns << "\t\t" << list_ns / ring_ns << "x" << std::endl;
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
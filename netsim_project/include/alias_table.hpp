@@ -0,0 +1,29 @@
+#ifndef ALIAS_TABLE_HPP_
+#define ALIAS_TABLE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Kolumna tablicy aliasów Walkera/Vose'a: z prawdopodobieństwem `probability` wybierana jest
+// sama kolumna, w przeciwnym razie -- `alias`.
+struct AliasColumn {
+    double probability;
+    std::uint32_t alias;
+};
+
+// Buduje tablicę aliasów dla wag (nie muszą sumować się do 1) w O(n).
+void build_alias_table(const std::vector<double>& weights, std::vector<AliasColumn>& columns);
+// Wariant bez alokacji: `columns` i `worklist` wskazują na co najmniej n elementów pamięci wywołującego.
+void build_alias_table(const double* weights, std::size_t n, AliasColumn* columns, std::uint32_t* worklist);
+
+// Wybór w O(1) z jednej liczby z [0, 1]: część całkowita wskazuje kolumnę, ułamkowa rozstrzyga o aliasie.
+// Wartości spoza przedziału są przycinane, więc wynik zawsze jest poprawnym indeksem.
+inline std::size_t alias_pick(const AliasColumn* columns, std::size_t n, double probability) {
+    double x = (probability > 0 ? std::min(probability, 1.0) : 0.0) * double(n);
+    auto column = std::min(std::size_t(x), n - 1);
+    return x - double(column) < columns[column].probability ? column : columns[column].alias;
+}
+
+#endif /* ALIAS_TABLE_HPP_ */
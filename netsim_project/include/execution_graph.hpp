@@ -0,0 +1,81 @@
+#ifndef EXECUTION_GRAPH_HPP_
+#define EXECUTION_GRAPH_HPP_
+
+#include "alias_table.hpp"
+#include "nodes.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Zwarty uchwyt odbiorcy: 3 najstarsze bity określają rodzaj węzła i typ jego kolejki/zapasu,
+// pozostałe -- indeks w tablicy robotników albo magazynów grafu.
+class ReceiverHandle {
+public:
+    enum class Kind : std::uint32_t {
+        RING_WORKER, PRIORITY_WORKER, OTHER_WORKER, RING_STOREHOUSE, BITMAP_STOREHOUSE, OTHER_STOREHOUSE
+    };
+
+    static constexpr unsigned index_bits = 29;
+
+    ReceiverHandle(Kind kind, std::size_t index)
+        : value_((static_cast<std::uint32_t>(kind) << index_bits) | static_cast<std::uint32_t>(index)) {}
+
+    Kind kind() const { return static_cast<Kind>(value_ >> index_bits); }
+    std::size_t index() const { return value_ & ((std::uint32_t(1) << index_bits) - 1); }
+
+private:
+    std::uint32_t value_;
+};
+
+// Zamrożona topologia fabryki, zbudowana przez `Factory::compile()`.
+// Nadawcy (najpierw rampy, potem robotnicy) mają połączenia w postaci CSR: krawędzie nadawcy `s`
+// zajmują przedział [offsets_[s], offsets_[s + 1]) tablic `targets_` i `alias_table_`.
+// Przekazanie półproduktu rozgałęzia się po rodzaju uchwytu i wywołuje kolejkę/zapas bezpośrednio;
+// implementacje spoza biblioteki obsługiwane są przez interfejsy wirtualne.
+// Stan symulacji pozostaje w węzłach; graf jest ważny, dopóki nie zmieni się struktura fabryki.
+class ExecutionGraph {
+public:
+    explicit ExecutionGraph(SimulationContext& context) : context_(&context) {}
+
+    void do_deliveries(Time time);
+    void do_package_passing();
+    void do_work(Time time);
+
+    std::size_t sender_count() const { return senders_.size(); }
+    std::size_t edge_count() const { return targets_.size(); }
+    // Połączenia do odbiorców spoza biblioteki, obsługiwane przez interfejsy wirtualne.
+    std::size_t virtual_edge_count() const;
+
+private:
+    friend class Factory;
+
+    void send_package(std::size_t sender);
+    ReceiverHandle choose_receiver(std::size_t sender);
+
+    template <class Discipline>
+    void hand_to_worker(Worker& worker, std::optional<Package>& buffer);
+    template <class Discipline>
+    static void work(const std::vector<Worker*>& workers, Time time);
+
+    SimulationContext* context_;
+    std::vector<Ramp*> ramps_;
+    std::vector<Worker*> workers_;
+    std::vector<Storehouse*> storehouses_;
+    std::vector<PackageSender*> senders_;
+
+    // Robotnicy pogrupowani według dyscypliny kolejki -- do_work nie zależy od kolejności robotników.
+    std::vector<Worker*> fifo_workers_;
+    std::vector<Worker*> lifo_workers_;
+    std::vector<Worker*> priority_workers_;
+    std::vector<Worker*> other_workers_;
+
+    std::vector<std::size_t> offsets_;
+    std::vector<ReceiverHandle> targets_;
+    // Tablice aliasów nadawców (aliasy względem początku przedziału) -- ten sam wybór co ReceiverPreferences::choose_receiver().
+    std::vector<AliasColumn> alias_table_;
+};
+
+#endif /* EXECUTION_GRAPH_HPP_ */
@@ -1,52 +1,150 @@
 #ifndef FACTORY_HPP_
 #define FACTORY_HPP_
 
+#include "execution_graph.hpp"
 #include "nodes.hpp"
+#include "slot_map.hpp"
+#include "topology.hpp"
 #include "types.hpp"
 #include "algorithm"
 
 #include <stdexcept>
-#include <list>
+#include <iterator>
+#include <optional>
+#include <type_traits>
 #include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 template <class Node>
 class NodeCollection {
+private:
+    // Iteruje po gęstej tablicy wskaźników SlotMap; pozycja (a nie wskaźnik) pozostaje ważna po dodaniu węzła.
+    template <bool Const>
+    class basic_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const Node*, Node*>;
+        using reference = std::conditional_t<Const, const Node&, Node&>;
+
+        basic_iterator() = default;
+        basic_iterator(const std::vector<Node*>* dense, std::size_t position) : dense_(dense), position_(position) {}
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        basic_iterator(const basic_iterator<false>& other) : dense_(other.dense_), position_(other.position_) {}
+
+        reference operator*() const { return *(*dense_)[position_]; }
+        pointer operator->() const { return (*dense_)[position_]; }
+        reference operator[](difference_type n) const { return *(*dense_)[std::size_t(difference_type(position_) + n)]; }
+
+        basic_iterator& operator++() { ++position_; return *this; }
+        basic_iterator operator++(int) { auto tmp = *this; ++position_; return tmp; }
+        basic_iterator& operator--() { --position_; return *this; }
+        basic_iterator operator--(int) { auto tmp = *this; --position_; return tmp; }
+        basic_iterator& operator+=(difference_type n) { position_ = std::size_t(difference_type(position_) + n); return *this; }
+        basic_iterator& operator-=(difference_type n) { return *this += -n; }
+        basic_iterator operator+(difference_type n) const { auto tmp = *this; return tmp += n; }
+        basic_iterator operator-(difference_type n) const { auto tmp = *this; return tmp -= n; }
+        difference_type operator-(const basic_iterator& other) const { return difference_type(position_) - difference_type(other.position_); }
+
+        // Jako przyjaciele, by porównywać także iterator z const_iterator (jak w std::list).
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.position_ == b.position_ && a.dense_ == b.dense_; }
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return !(a == b); }
+        friend bool operator<(const basic_iterator& a, const basic_iterator& b) { return a.position_ < b.position_; }
+
+    private:
+        friend class basic_iterator<true>;
+
+        const std::vector<Node*>* dense_ = nullptr;
+        std::size_t position_ = 0;
+    };
+
 public:
-    using container_t = typename std::list<Node>;
-    using iterator = typename container_t::iterator;
-    using const_iterator = typename container_t::const_iterator;
+    using container_t = SlotMap<Node>;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    NodeCollection() = default;
+    NodeCollection(const NodeCollection&) = delete;
+    NodeCollection& operator=(const NodeCollection&) = delete;
+    NodeCollection(NodeCollection&&) = default;
+    NodeCollection& operator=(NodeCollection&&) = default;
 
-    void add(Node&& node) { nodes_.emplace_back(std::move(node)); }
+    Node& add(Node&& node) {
+        ElementID id = node.get_id();
+        if (index_.count(id)) {
+            throw std::invalid_argument("Duplicate node ID: " + std::to_string(id));
+        }
+        auto handle = nodes_.insert(std::move(node));
+        index_.emplace(id, handle);
+        return *nodes_.get(handle);
+    }
 
+    void clear() {
+        nodes_.clear();
+        index_.clear();
+    }
+
+    void reserve(std::size_t n) {
+        nodes_.reserve(n);
+        index_.reserve(n);
+    }
+
+    // Zachowuje kolejność pozostałych węzłów (kolejność zapisu i symulacji nie zależy od usunięć).
     void remove_by_id(ElementID id) {
-        auto it = find_by_id(id);
-        if (it != nodes_.end()) {
-            nodes_.erase(it);
+        auto it = index_.find(id);
+        if (it != index_.end()) {
+            nodes_.erase(it->second);
+            index_.erase(it);
         }
     }
 
-    NodeCollection<Node>::iterator find_by_id(ElementID id) {
-        return std::find_if(nodes_.begin(), nodes_.end(), [id](const Node& node) {
-            return node.get_id() == id;
+    template <typename Pred>
+    void remove_if(Pred pred) {
+        nodes_.erase_if([this, &pred](const Node& node) {
+            if (!pred(node)) {
+                return false;
+            }
+            index_.erase(node.get_id());
+            return true;
         });
     }
 
+    // Uchwyt pozostaje ważny (i jednoznaczny) niezależnie od usuwania innych węzłów.
+    std::optional<SlotHandle> find_handle(ElementID id) const {
+        auto it = index_.find(id);
+        return it != index_.end() ? std::optional<SlotHandle>(it->second) : std::nullopt;
+    }
+
+    Node* get(SlotHandle handle) { return nodes_.get(handle); }
+    const Node* get(SlotHandle handle) const { return nodes_.get(handle); }
+
+    NodeCollection<Node>::iterator find_by_id(ElementID id) {
+        auto it = index_.find(id);
+        return it != index_.end() ? iterator(&nodes_.dense(), nodes_.position(it->second)) : end();
+    }
+
     NodeCollection<Node>::const_iterator find_by_id(ElementID id) const {
-        return std::find_if(nodes_.cbegin(), nodes_.cend(), [id](const Node& node) {
-            return node.get_id() == id;
-        });
+        auto it = index_.find(id);
+        return it != index_.end() ? const_iterator(&nodes_.dense(), nodes_.position(it->second)) : cend();
     }
 
-    NodeCollection<Node>::iterator begin() { return nodes_.begin(); }
-    NodeCollection<Node>::iterator end() { return nodes_.end(); }
+    NodeCollection<Node>::iterator begin() { return iterator(&nodes_.dense(), 0); }
+    NodeCollection<Node>::iterator end() { return iterator(&nodes_.dense(), nodes_.size()); }
+
+    NodeCollection<Node>::const_iterator cbegin() const { return const_iterator(&nodes_.dense(), 0); }
+    NodeCollection<Node>::const_iterator cend() const { return const_iterator(&nodes_.dense(), nodes_.size()); }
+    NodeCollection<Node>::const_iterator begin() const { return cbegin(); }
+    NodeCollection<Node>::const_iterator end() const { return cend(); }
 
-    NodeCollection<Node>::const_iterator cbegin() const { return nodes_.cbegin(); }
-    NodeCollection<Node>::const_iterator cend() const { return nodes_.cend(); }
-    NodeCollection<Node>::const_iterator begin() const { return nodes_.begin(); }
-    NodeCollection<Node>::const_iterator end() const { return nodes_.end(); }
+    std::size_t size() const { return nodes_.size(); }
 
 private:
     container_t nodes_;
+    std::unordered_map<ElementID, SlotHandle> index_;
 };
 
 
@@ -69,8 +167,52 @@ public:
 };
 
 
+enum ElementType {
+    RAMP, WORKER, STOREHOUSE, LINK
+};
+
+// Wynik sprawdzenia spójności: wszyscy nadawcy osiągalni z ramp, którzy nie mogą dostarczyć półproduktu
+// do magazynu, oraz osobno robotnicy, do których nie dociera żadna rampa.
+struct ConsistencyReport {
+    enum class Problem {
+        NO_RECEIVERS,          // brak odbiorców
+        NO_PATH_TO_STOREHOUSE  // są odbiorcy, ale żadna ścieżka nie kończy się w magazynie
+    };
+
+    struct Offender {
+        ElementType type;  // RAMP albo WORKER
+        ElementID id;
+        Problem problem;
+    };
+
+    std::vector<Offender> offenders;
+    // Nie blokują symulacji (nie dostaną żadnego półproduktu), ale zwykle świadczą o błędzie
+    // w połączeniach; usuwa ich `Factory::prune_unreachable()`.
+    std::vector<ElementID> unreachable_workers;
+
+    bool ok() const { return offenders.empty(); }
+};
+
+
+// Węzły usunięte przez `Factory::prune_unreachable()`.
+struct PruneReport {
+    std::vector<ElementID> workers;
+    std::vector<ElementID> storehouses;
+
+    bool empty() const { return workers.empty() && storehouses.empty(); }
+};
+
+
 class Factory {
 public:
+    explicit Factory(SimulationContext& context = SimulationContext::current());
+    Factory(Factory&& factory) = default;
+    Factory& operator=(Factory&& factory) noexcept;
+    ~Factory();
+
+    SimulationContext& get_context() const { return *context_; }
+    void reserve(std::size_t ramps, std::size_t workers, std::size_t storehouses);
+
     //---RAMP---//
     void add_ramp(Ramp&& ramp);
     void remove_ramp(ElementID id);
@@ -98,33 +240,48 @@ public:
     NodeCollection<Storehouse>::const_iterator storehouse_cbegin() const { return storehouse_.cbegin(); }
     NodeCollection<Storehouse>::const_iterator storehouse_cend() const { return storehouse_.cend(); }
 
-    bool is_consistent() const;
+    // Nadawcy połączeni z danym odbiorcą.
+    const std::vector<PackageSender*>& get_senders(const IPackageReceiver& receiver) const { return senders_->get_senders(&receiver); }
+
+    // Iteracyjnie, w czasie O(V + E); węzły nieosiągalne z ramp nie są sprawdzane.
+    ConsistencyReport check_consistency() const;
+    // O(1): stan osiągalności utrzymywany jest przyrostowo przy każdej zmianie struktury.
+    bool is_consistent() const { return reachability_->offender_count() == 0; }
+    // Usuwa robotników i magazyny, do których nie dociera żaden półprodukt z ramp.
+    PruneReport prune_unreachable();
+
+    // Układa robotników i magazyny w pamięci w kolejności BFS od ramp, tak by nadawca i jego odbiorcy
+    // leżeli blisko siebie; połączenia są przepinane na nowe adresy. Unieważnia wskaźniki i referencje do węzłów.
+    void reorder_for_locality();
+
+    // Zamraża bieżącą strukturę do postaci płaskich tablic, po których przechodzi `simulate()`.
+    ExecutionGraph compile();
+
     void do_deliveries(Time time);
     void do_package_passing();
     void do_work(Time time);
 
 private:
-    template<typename Node>
-    void remove_receiver(NodeCollection<Node>& collection, ElementID id) {
-        for (auto& node : collection) {
-            node.remove_receiver(id);
-        }
-    }
+    friend class FactoryBuilder;
+
+    void attach_sender(PackageSender& sender);
+    void detach_sender(PackageSender& sender);
+    void detach_receiver(IPackageReceiver& receiver);
 
+    void clear();
+
+    SimulationContext* context_;
     NodeCollection<Ramp> ramp_;
     NodeCollection<Worker> worker_;
     NodeCollection<Storehouse> storehouse_;
+    // Na stercie, by adres obserwatora przetrwał przeniesienie fabryki.
+    std::unique_ptr<SenderIndex> senders_;
+    std::unique_ptr<ReachabilityTracker> reachability_;
 };
 
-enum class node_colour {
-    NOT_VISITED, VISITED, CHECKED
-};
-
-enum ElementType {
-    RAMP, WORKER, STOREHOUSE, LINK
-};
+std::string PackageQueueType_string_(PackageQueueType type);
 
-Factory load_factory_structure(std::istream& is);
+Factory load_factory_structure(std::istream& is, SimulationContext& context = SimulationContext::current());
 
 void save_factory_structure(Factory& factory, std::ostream& os);
 
@@ -0,0 +1,65 @@
+#ifndef FACTORY_BUILDER_HPP_
+#define FACTORY_BUILDER_HPP_
+
+#include "factory.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+struct RampRecord {
+    ElementID id;
+    TimeOffset delivery_interval;
+};
+
+struct WorkerRecord {
+    ElementID id;
+    TimeOffset processing_time;
+    PackageQueueType queue_type = PackageQueueType::FIFO;
+    std::optional<std::size_t> capacity = std::nullopt;
+};
+
+struct StorehouseRecord {
+    ElementID id;
+    std::optional<StockpileType> stock_type = std::nullopt;
+};
+
+struct LinkRecord {
+    ElementType src_type;
+    ElementID src_id;
+    ReceiverType dest_type;
+    ElementID dest_id;
+    double weight = 1.0;
+};
+
+// Zbiera opis fabryki w postaci rekordów i buduje ją za jednym razem:
+// kolekcje są rezerwowane raz, a połączenia dodawane grupami według nadawcy; `p=` w połączeniu to waga (domyślnie 1).
+class FactoryBuilder {
+public:
+    explicit FactoryBuilder(SimulationContext& context = SimulationContext::current()) : context_(&context) {}
+
+    void reserve(std::size_t ramps, std::size_t workers, std::size_t storehouses, std::size_t links);
+
+    void add_ramp(const RampRecord& record) { ramps_.push_back(record); }
+    void add_worker(const WorkerRecord& record) { workers_.push_back(record); }
+    void add_storehouse(const StorehouseRecord& record) { storehouses_.push_back(record); }
+    void add_link(const LinkRecord& record) { links_.push_back(record); }
+
+    void add_ramps(const std::vector<RampRecord>& records) { ramps_.insert(ramps_.end(), records.begin(), records.end()); }
+    void add_workers(const std::vector<WorkerRecord>& records) { workers_.insert(workers_.end(), records.begin(), records.end()); }
+    void add_storehouses(const std::vector<StorehouseRecord>& records) { storehouses_.insert(storehouses_.end(), records.begin(), records.end()); }
+    void add_links(const std::vector<LinkRecord>& records) { links_.insert(links_.end(), records.begin(), records.end()); }
+
+    // Rzuca std::invalid_argument, gdy połączenie wskazuje nieistniejący węzeł.
+    Factory build() const;
+
+private:
+    SimulationContext* context_;
+    std::vector<RampRecord> ramps_;
+    std::vector<WorkerRecord> workers_;
+    std::vector<StorehouseRecord> storehouses_;
+    std::vector<LinkRecord> links_;
+};
+
+#endif /* FACTORY_BUILDER_HPP_ */
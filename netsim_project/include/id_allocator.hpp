@@ -0,0 +1,35 @@
+#ifndef ID_ALLOCATOR_HPP_
+#define ID_ALLOCATOR_HPP_
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Przydziela najmniejsze wolne ID (numerowane od 1).
+// Hierarchiczna mapa bitowa: na poziomie 0 bit ustawiony oznacza wolne ID,
+// na poziomie k+1 bit ustawiony oznacza, że odpowiadające mu słowo poziomu k nie jest zerowe.
+// Przydział i zwolnienie kosztują O(log_64 n), bez alokacji na pojedyncze ID.
+class IdAllocator {
+public:
+    ElementID allocate();
+    void reserve(ElementID id);
+    void release(ElementID id);
+
+    bool is_assigned(ElementID id) const;
+    std::size_t size() const { return assigned_; }
+    std::size_t capacity() const { return levels_.empty() ? 0 : levels_.front().size() * word_bits_; }
+
+private:
+    static constexpr std::size_t word_bits_ = 64;
+
+    void grow(std::size_t min_capacity);
+    void mark_assigned(std::size_t bit);
+    void mark_free(std::size_t bit);
+
+    std::vector<std::vector<std::uint64_t>> levels_;
+    std::size_t assigned_ = 0;
+};
+
+#endif /* ID_ALLOCATOR_HPP_ */
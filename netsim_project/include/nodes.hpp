@@ -3,13 +3,20 @@
 
 #include "config.hpp"
 #include "types.hpp"
+#include "alias_table.hpp"
 #include "package.hpp"
+#include "small_flat_map.hpp"
 #include "storage_types.hpp"
-#include "helpers.hpp"
+#include "simulation_context.hpp"
 
-#include <map>
+#include <array>
+#include <cstdint>
+#include <iterator>
 #include <optional>
+#include <stdexcept>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 enum class ReceiverType {
     WORKER, STOREHOUSE
@@ -28,54 +35,197 @@ public:
 
     virtual ElementID get_id() const = 0;
     virtual void receive_package(Package &&p) = 0;
+    // Odbiorca z pełną kolejką odmawia przyjęcia -- nadawca zatrzymuje półprodukt i ponawia próbę.
+    virtual bool can_receive_package() const { return true; }
 
     virtual ~IPackageReceiver() = default;
 };
 
 
-class ReceiverPreferences {
+class PackageSender;
+
+// Powiadamiany o zmianach połączeń nadawcy (np. przez fabrykę utrzymującą indeks odwrotny).
+class IReceiverPreferencesObserver {
 public:
-    using preferences_t = std::map<IPackageReceiver*, double>;
-    using const_iterator = typename preferences_t::const_iterator;
+    virtual void on_receiver_added(PackageSender& sender, IPackageReceiver* receiver) = 0;
+    virtual void on_receiver_removed(PackageSender& sender, IPackageReceiver* receiver) = 0;
+
+    virtual ~IReceiverPreferencesObserver() = default;
+};
+
 
-    explicit ReceiverPreferences(ProbabilityGenerator pg = probability_generator): pg_(std::move(pg)) {};
+// Klucz strumienia losowań nadawcy: rodzaj w starszej połowie, ID w młodszej.
+enum class SenderKind : std::uint32_t {
+    RAMP = 1, WORKER = 2
+};
+
+inline std::uint64_t sender_stream(SenderKind kind, ElementID id) {
+    return (std::uint64_t(kind) << 32) | std::uint32_t(id);
+}
 
-    const_iterator cbegin() const {return preferences_t_.cbegin(); }
-    const_iterator cend() const {return preferences_t_.cend(); }
-    const_iterator begin() const {return preferences_t_.begin(); }
-    const_iterator end() const {return preferences_t_.end(); }
 
-    void add_receiver(IPackageReceiver *r);
+// Połączenia nadawcy z surowymi wagami, w kolejności dodania; do czterech mieszczą się w samym obiekcie.
+// Prawdopodobieństwa nie są przechowywane -- iteracja wylicza je w locie z wag.
+class ReceiverPreferences {
+public:
+    using preferences_t = SmallFlatMap<IPackageReceiver*, double>;
+
+    // Pary (odbiorca, prawdopodobieństwo) zwracane przez wartość.
+    class const_iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<IPackageReceiver*, double>;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        struct pointer {
+            value_type value;
+            const value_type* operator->() const { return &value; }
+        };
+
+        const_iterator(preferences_t::const_iterator it, double total, std::size_t n) : it_(it), total_(total), n_(n) {}
+
+        reference operator*() const { return {it_->first, normalize(it_->second, total_, n_)}; }
+        pointer operator->() const { return {**this}; }
+        const_iterator& operator++() {
+            ++it_;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            auto copy = *this;
+            ++it_;
+            return copy;
+        }
+        bool operator==(const const_iterator& other) const { return it_ == other.it_; }
+        bool operator!=(const const_iterator& other) const { return it_ != other.it_; }
+
+    private:
+        preferences_t::const_iterator it_;
+        double total_;
+        std::size_t n_;
+    };
+
+    // Widok prawdopodobieństw (wagi podzielone przez ich sumę; same zera -- po równo) bez własnej kopii danych.
+    // Ważny do zmiany preferencji.
+    class ProbabilityView {
+    public:
+        explicit ProbabilityView(const preferences_t& weights) : weights_(&weights), total_(0.0) {
+            for (const auto& rec : weights) {
+                total_ += rec.second;
+            }
+        }
+
+        const_iterator begin() const { return make(weights_->begin()); }
+        const_iterator end() const { return make(weights_->end()); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+        const_iterator find(IPackageReceiver* r) const { return make(weights_->find(r)); }
+        std::size_t size() const { return weights_->size(); }
+        bool empty() const { return weights_->empty(); }
+        double at(IPackageReceiver* r) const { return normalize(weights_->at(r), total_, size()); }
+        double operator[](IPackageReceiver* r) const { return at(r); }
+
+    private:
+        const_iterator make(preferences_t::const_iterator it) const { return const_iterator(it, total_, size()); }
+
+        const preferences_t* weights_;
+        double total_;
+    };
+
+    explicit ReceiverPreferences(SimulationContext& context = SimulationContext::current()): context_(&context) {};
+
+    void bind(SimulationContext& context) { context_ = &context; }
+    SimulationContext& context() const { return *context_; }
+    void observe(PackageSender* owner, IReceiverPreferencesObserver* observer) {
+        owner_ = owner;
+        observer_ = observer;
+    }
+
+    const_iterator cbegin() const { return get_preferences().cbegin(); }
+    const_iterator cend() const { return get_preferences().cend(); }
+    const_iterator begin() const { return cbegin(); }
+    const_iterator end() const { return cend(); }
+
+    // Ponowne dodanie odbiorcy zmienia tylko jego wagę. Rzuca std::invalid_argument dla wagi ujemnej lub nieskończonej.
+    void add_receiver(IPackageReceiver *r, double weight = 1.0);
+    // Dodaje wielu odbiorców naraz z pary (odbiorca, waga).
+    template <typename InputIt>
+    void add_receivers(InputIt first, InputIt last);
     void remove_receiver(IPackageReceiver *r);
+    // Podmienia wskaźniki odbiorców przeniesionych w pamięci, zachowując wagi; bez powiadomień.
+    void relocate(const std::unordered_map<const IPackageReceiver*, IPackageReceiver*>& relocation);
+    // O(1) dzięki tablicy aliasów; jedyny odbiorca -- bez losowania. Dla małej liczby odbiorców tablica
+    // budowana jest na stosie przy każdym losowaniu, dla większej -- przechowywana do zmiany preferencji.
+    // Zwraca nullptr tylko przy braku odbiorców.
     IPackageReceiver* choose_receiver();
-    const preferences_t& get_preferences() const {return preferences_t_;}
+    // Rampy i robotnicy losują z własnego strumienia (zob. `sender_stream`); bez strumienia (0) --
+    // ze wspólnego generatora kontekstu.
+    void set_stream(std::uint64_t stream) { stream_ = stream; }
+    double draw_probability();
+    // Prawdopodobieństwa liczone w locie z surowych wag.
+    ProbabilityView get_preferences() const { return ProbabilityView(weights_); }
+    // Surowe wagi -- wystarczą tam, gdzie liczą się tylko odbiorcy.
+    const preferences_t& get_weights() const { return weights_; }
+    // Czy wagi i tablica aliasów mieszczą się w obiekcie.
+    bool is_inline() const { return weights_.is_inline() && !alias_table_; }
 
 private:
-    ProbabilityGenerator pg_;
-    preferences_t preferences_t_;
+    static double normalize(double weight, double total, std::size_t n) {
+        return total > 0 ? weight / total : 1.0 / double(n);
+    }
+    void invalidate() { alias_table_.reset(); }
+    void rebuild_alias_table();
+
+    SimulationContext* context_;
+    preferences_t weights_;
+    // Tylko dla więcej niż `preferences_t::inline_capacity` odbiorców; pusty, gdy nieaktualny.
+    std::unique_ptr<AliasColumn[]> alias_table_;
+    std::uint64_t stream_ = 0;
+    Time draw_turn_ = 0;
+    std::uint32_t draws_ = 0;
+    PackageSender* owner_ = nullptr;
+    IReceiverPreferencesObserver* observer_ = nullptr;
 };
 
 
+template <typename InputIt>
+void ReceiverPreferences::add_receivers(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+        add_receiver(first->first, first->second);
+    }
+}
+
+
 class PackageSender {
 public:
     ReceiverPreferences receiver_preferences_;
 
     PackageSender() = default;
     PackageSender(PackageSender &&pack_sender) = default;
+    ~PackageSender() { release_into_context(bufor_); }
     void send_package();
     const std::optional<Package> &get_sending_buffer() const { return bufor_; }
 
 protected:
-    void push_package(Package &&package) { bufor_.emplace(package.get_id()); };
+    void push_package(Package &&package) { bufor_.emplace(std::move(package)); };
+    // Kontekst, z którego pochodzą i do którego wracają ID półproduktów nadawcy.
+    SimulationContext& context() const { return receiver_preferences_.context(); }
+    // Zwalnia ID półproduktu z bufora w kontekście nadawcy, niezależnie od kontekstu bieżącego.
+    void release_into_context(std::optional<Package>& bufor) const noexcept;
 
 private:
+    friend class ExecutionGraph;
+
     std::optional<Package> bufor_ = std::nullopt;
 };
 
 
-class Storehouse : public IPackageReceiver {
+class Storehouse final : public IPackageReceiver {
 public:
-    Storehouse(ElementID id, std::unique_ptr<IPackageStockpile> d = std::make_unique<PackageQueue>(PackageQueueType::FIFO)) : id_(id), d_(std::move(d)) {}
+    explicit Storehouse(ElementID id, SimulationContext& context = SimulationContext::current())
+        : id_(id), d_(make_default_stockpile(context)) {}
+    Storehouse(ElementID id, std::unique_ptr<IPackageStockpile> d) : id_(id), d_(std::move(d)) {}
+    Storehouse(ElementID id, StockpileType type, SimulationContext& context = SimulationContext::current())
+        : id_(id), d_(make_stockpile(type, context.stockpile_options(), context)), stockpile_type_(type) {}
 
     using const_iterator = typename IPackageStockpile::const_iterator;
 
@@ -84,20 +234,43 @@ public:
     const_iterator begin() const override { return d_->begin(); }
     const_iterator end() const override { return d_->end(); }
 
+    const IPackageStockpile& get_stockpile() const { return *d_; }
+    // Przenosi pusty magazyn do innego kontekstu (zob. `IPackageStockpile::bind`).
+    void bind(SimulationContext& context) { d_->bind(context); }
+    // Typ zapasu, jeśli wybrano go dla tego magazynu (inaczej obowiązuje domyślny z kontekstu).
+    std::optional<StockpileType> get_stockpile_type() const { return stockpile_type_; }
+
     void receive_package(Package &&p) override;
+    template <class Stockpile>
+    void receive_as(Package &&p) { static_cast<Stockpile&>(*d_).push(std::move(p)); }
     ElementID get_id() const override { return id_; }
 
     ReceiverType get_receiver_type() const override { return ReceiverType::STOREHOUSE; }
 
 private:
+    static std::unique_ptr<IPackageStockpile> make_default_stockpile(SimulationContext& context) {
+        auto& options = context.stockpile_options();
+        return make_stockpile(options.type, options, context);
+    }
+
     ElementID id_;
     std::unique_ptr<IPackageStockpile> d_;
+    std::optional<StockpileType> stockpile_type_;
 };
 
 
-class Worker : public IPackageReceiver, public PackageSender {
+class Worker final : public IPackageReceiver, public PackageSender {
 public:
-    Worker(ElementID id, TimeOffset pd, std::unique_ptr<IPackageQueue> q) : PackageSender(), id_(id), pd_(pd), q_(std::move(q)) {}
+    Worker(ElementID id, TimeOffset pd, std::unique_ptr<IPackageQueue> q, std::optional<std::size_t> capacity = std::nullopt)
+        : PackageSender(), id_(id), pd_(pd), q_(std::move(q)), capacity_(capacity) {
+        // Robotnik o pojemności 0 nigdy nie przyjąłby półproduktu -- blokowałby wszystkich nadawców.
+        if (capacity_ && *capacity_ == 0) {
+            throw std::invalid_argument("Worker capacity must be positive");
+        }
+        receiver_preferences_.set_stream(sender_stream(SenderKind::WORKER, id));
+    }
+    Worker(Worker &&worker) = default;
+    ~Worker() override { release_into_context(bufor_); }
 
     using const_iterator = typename IPackageStockpile::const_iterator;
 
@@ -107,29 +280,60 @@ public:
     const_iterator end() const override { return q_->end(); }
 
     IPackageQueue *get_queue() const { return q_.get(); }
+    // Przenosi pustego robotnika do innego kontekstu (zob. `IPackageStockpile::bind`).
+    void bind(SimulationContext& context);
 
-    void do_work(Time t);
+    void do_work(Time t) { do_work_as<VirtualDiscipline>(t); }
     TimeOffset get_processing_duration() const { return pd_; }
     Time get_package_processing_start_time() const { return t_; }
 
     void receive_package(Package &&p) override;
+    bool can_receive_package() const override { return !capacity_ || q_->size() < *capacity_; }
     ElementID get_id() const override { return id_; }
+    std::optional<std::size_t> get_capacity() const { return capacity_; }
 
     ReceiverType get_receiver_type() const override { return ReceiverType::WORKER; };
 
     std::optional<Package> const& get_processing_buffer() const { return bufor_; }
 
+    // Ścieżka bez wywołań wirtualnych; `Discipline` musi odpowiadać faktycznemu typowi kolejki.
+    template <class Discipline>
+    void do_work_as(Time t);
+    template <class Discipline>
+    bool can_receive_as() const { return !capacity_ || queue_as<Discipline>().size() < *capacity_; }
+    template <class Discipline>
+    void receive_as(Package &&p) { queue_as<Discipline>().push(std::move(p)); }
+
 private:
+    template <class Discipline>
+    typename Discipline::queue_t& queue_as() const { return static_cast<typename Discipline::queue_t&>(*q_); }
+
     ElementID id_;
     TimeOffset pd_;
     Time t_;
     std::unique_ptr<IPackageQueue> q_;
+    std::optional<std::size_t> capacity_;
     std::optional<Package> bufor_ = std::nullopt;
 };
 
+template <class Discipline>
+void Worker::do_work_as(Time t) {
+    auto& queue = queue_as<Discipline>();
+    if (!bufor_ && !queue.empty()) {
+        bufor_.emplace(Discipline::pop(queue));
+        t_ = t;
+    }
+    if (bufor_ && t - t_ + 1 >= pd_ && !get_sending_buffer()) {
+        push_package(std::move(*bufor_));
+        bufor_.reset();
+    }
+}
+
 class Ramp : public PackageSender {
 public:
-    Ramp(ElementID id, TimeOffset di) : PackageSender(), id_(id), di_(di) {}
+    Ramp(ElementID id, TimeOffset di) : PackageSender(), id_(id), di_(di) {
+        receiver_preferences_.set_stream(sender_stream(SenderKind::RAMP, id));
+    }
     void deliver_goods(Time t);
     TimeOffset get_delivery_interval() const { return di_; }
     ElementID get_id() const { return id_; }
@@ -137,8 +341,6 @@ public:
 private:
     ElementID id_;
     TimeOffset di_;
-    Time t_;
-    std::optional<Package> bufor_ = std::nullopt;
 };
 
 #endif /* NODES_HPP_ */
\ No newline at end of file
@@ -2,23 +2,70 @@
 #define PACKAGE_HPP_
 
 #include "types.hpp"
-#include <set>
 
+// 32-bitowy uchwyt do slotu w magazynie półproduktów (`PackageSlab`) kontekstu bieżącego
+// (`SimulationContext::current()`); ID półproduktu jest zarazem numerem slotu.
+// Przeniesienie tylko przekazuje uchwyt -- półprodukt, z którego przeniesiono, jest pusty
+// i przy zniszczeniu niczego nie zwalnia. Kolejki, magazyny i węzły pamiętają swój kontekst
+// i zwalniają w nim przechowywane ID same, bez względu na kontekst bieżący.
 class Package {
 public:
+    static constexpr ElementID EMPTY_ID = 0;
+
     Package();
 
-    explicit Package(ElementID ID) : ID_(ID) { assigned_IDs.insert(ID_); }
-    Package(Package &&package)  noexcept : ID_(package.ID_) {}
-    Package &operator=(Package &&package) noexcept ;
+    explicit Package(ElementID ID);
+    Package(Package &&package) noexcept : ID_(package.ID_) { package.ID_ = EMPTY_ID; }
+
+    Package &operator=(Package &&package) noexcept {
+        if (this != &package) {
+            if (ID_ != EMPTY_ID) {
+                release();
+            }
+            ID_ = package.ID_;
+            package.ID_ = EMPTY_ID;
+        }
+        return *this;
+    }
+
     ElementID get_id() const { return ID_; }
 
-    ~Package();
+    // Oddaje uchwyt bez zwalniania ID -- np. kolejce, która przechowuje same ID.
+    ElementID release_handle() noexcept {
+        ElementID ID = ID_;
+        ID_ = EMPTY_ID;
+        return ID;
+    }
+
+    // Przejmuje uchwyt oddany wcześniej przez `release_handle()`.
+    static Package adopt_handle(ElementID ID) noexcept { return Package(ID, adopt_tag()); }
+
+    ~Package() {
+        if (ID_ != EMPTY_ID) {
+            release();
+        }
+    }
+
+private:
+    struct adopt_tag {};
+
+    Package(ElementID ID, adopt_tag) noexcept : ID_(ID) {}
+
+    void release() noexcept;
+
+    ElementID ID_;
+};
+
+// Widok (bez własności) półproduktu przechowywanego w kolejce lub magazynie.
+class PackageView {
+public:
+    explicit PackageView(ElementID ID = Package::EMPTY_ID) : ID_(ID) {}
+    ElementID get_id() const { return ID_; }
 
 private:
     ElementID ID_;
-    static std::set<ElementID> assigned_IDs;
-    static std::set<ElementID> freed_IDs;
 };
 
-#endif /* PACKAGE_HPP_ */
\ No newline at end of file
+static_assert(sizeof(Package) == sizeof(ElementID), "Package must stay a 32-bit handle");
+
+#endif /* PACKAGE_HPP_ */
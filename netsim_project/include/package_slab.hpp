@@ -0,0 +1,68 @@
+#ifndef PACKAGE_SLAB_HPP_
+#define PACKAGE_SLAB_HPP_
+
+#include "types.hpp"
+#include "id_allocator.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+enum class PackageAttribute {
+    CREATION_TURN, SOURCE_RAMP, HOP_COUNT
+};
+
+// Magazyn półproduktów jednej symulacji. `Package` jest jedynie 32-bitowym uchwytem (ID),
+// a ID to zarazem numer slotu, pod którym w kolumnach leżą opcjonalne atrybuty.
+// Kolumna jest alokowana dopiero po włączeniu danego atrybutu przez `enable()`.
+class PackageSlab {
+public:
+    ElementID create();
+    void reserve(ElementID id);
+    void destroy(ElementID id) { ids_.release(id); }
+
+    bool contains(ElementID id) const { return ids_.is_assigned(id); }
+    std::size_t size() const { return ids_.size(); }
+
+    void enable(PackageAttribute attribute);
+    bool is_enabled(PackageAttribute attribute) const;
+
+    void record_origin(ElementID id, Time t, ElementID ramp_id);
+    void count_hop(ElementID id);
+
+    std::optional<Time> get_creation_turn(ElementID id) const { return get(creation_turn_, id); }
+    std::optional<ElementID> get_source_ramp(ElementID id) const { return get(source_ramp_, id); }
+    std::optional<std::uint32_t> get_hop_count(ElementID id) const { return get(hop_count_, id); }
+
+private:
+    template<typename T>
+    struct Column {
+        bool enabled = false;
+        std::vector<T> values;
+    };
+
+    template<typename T>
+    static std::optional<T> get(const Column<T>& column, ElementID id) {
+        if (!column.enabled || id <= 0 || static_cast<std::size_t>(id - 1) >= column.values.size()) {
+            return std::nullopt;
+        }
+        return column.values[static_cast<std::size_t>(id - 1)];
+    }
+
+    template<typename T>
+    void reset(Column<T>& column, ElementID id) {
+        if (column.enabled) {
+            column.values.resize(ids_.capacity());
+            column.values[static_cast<std::size_t>(id - 1)] = T();
+        }
+    }
+
+    void reset_slot(ElementID id);
+
+    IdAllocator ids_;
+    Column<Time> creation_turn_;
+    Column<ElementID> source_ramp_;
+    Column<std::uint32_t> hop_count_;
+};
+
+#endif /* PACKAGE_SLAB_HPP_ */
@@ -0,0 +1,35 @@
+#ifndef PHILOX_HPP_
+#define PHILOX_HPP_
+
+#include <array>
+#include <cstdint>
+
+// Philox4x32-10 (Salmon i in., "Parallel random numbers: as easy as 1, 2, 3"): generator licznikowy.
+// Wynik jest czystą funkcją pary (licznik, klucz) -- nie ma stanu, który trzeba by przekazywać między wątkami.
+using philox_counter_t = std::array<std::uint32_t, 4>;
+using philox_key_t = std::array<std::uint32_t, 2>;
+
+inline philox_counter_t philox4x32(philox_counter_t counter, philox_key_t key) {
+    constexpr std::uint32_t m0 = 0xD2511F53;
+    constexpr std::uint32_t m1 = 0xCD9E8D57;
+    constexpr std::uint32_t w0 = 0x9E3779B9;
+    constexpr std::uint32_t w1 = 0xBB67AE85;
+
+    for (int round = 0; round < 10; ++round) {
+        auto p0 = std::uint64_t(m0) * counter[0];
+        auto p1 = std::uint64_t(m1) * counter[2];
+        counter = {std::uint32_t(p1 >> 32) ^ counter[1] ^ key[0], std::uint32_t(p1),
+                   std::uint32_t(p0 >> 32) ^ counter[3] ^ key[1], std::uint32_t(p0)};
+        key[0] += w0;
+        key[1] += w1;
+    }
+    return counter;
+}
+
+// Liczba z [0, 1) z 53 bitów wyniku.
+inline double philox_canonical(const philox_counter_t& bits) {
+    auto x = (std::uint64_t(bits[0]) << 32) | bits[1];
+    return double(x >> 11) * 0x1.0p-53;
+}
+
+#endif /* PHILOX_HPP_ */
@@ -0,0 +1,72 @@
+#ifndef SIMULATION_CONTEXT_HPP_
+#define SIMULATION_CONTEXT_HPP_
+
+#include "types.hpp"
+#include "package_slab.hpp"
+#include "storage_types.hpp"
+#include "philox.hpp"
+#include "xoshiro.hpp"
+
+#include <cstdint>
+#include <random>
+
+// Stan współdzielony przez jedną symulację: magazyn półproduktów (przestrzeń ID) i generatory losowe.
+// Każdy wątek ma własny kontekst domyślny; `Scope` podmienia kontekst bieżący na czas swojego życia.
+class SimulationContext {
+public:
+    using rng_t = Xoshiro256PlusPlus;
+
+    explicit SimulationContext(rng_t::result_type seed = std::random_device{}());
+    SimulationContext(const SimulationContext&) = delete;
+    SimulationContext& operator=(const SimulationContext&) = delete;
+
+    PackageSlab& packages() { return packages_; }
+    StockpileOptions& stockpile_options() { return stockpile_options_; }
+    rng_t& rng() { return rng_; }
+
+    // Domyślnie losuje wprost z `rng()` (rozwijane w miejscu wywołania); generator ustawiony przez
+    // `set_probability_generator` (np. atrapa w testach) ma pierwszeństwo aż do `reset_probability_generator()`.
+    double generate_probability() { return probability_generator_ ? probability_generator_() : rng_.canonical(); }
+    // Losowanie będące czystą funkcją (ziarno, strumień nadawcy, tura, numer losowania nadawcy w turze) --
+    // wynik nie zależy od kolejności ani wątku, w którym nadawcy losują. Atrapa ma pierwszeństwo jak wyżej.
+    double generate_probability(std::uint64_t stream, std::uint32_t draw) {
+        if (probability_generator_) {
+            return probability_generator_();
+        }
+        return philox_canonical(philox4x32(
+                {std::uint32_t(stream), std::uint32_t(stream >> 32), std::uint32_t(turn_), draw},
+                {std::uint32_t(seed_), std::uint32_t(seed_ >> 32)}));
+    }
+    void set_probability_generator(ProbabilityGenerator pg) { probability_generator_ = std::move(pg); }
+    void reset_probability_generator() { probability_generator_ = nullptr; }
+
+    rng_t::result_type seed() const { return seed_; }
+    // Ustawiana na początku tury przez `do_deliveries` fabryki i grafu wykonania.
+    void set_turn(Time turn) { turn_ = turn; }
+    Time turn() const { return turn_; }
+
+    static SimulationContext& current();
+
+    class Scope {
+    public:
+        explicit Scope(SimulationContext& context);
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope();
+
+    private:
+        SimulationContext* previous_;
+    };
+
+private:
+    PackageSlab packages_;
+    StockpileOptions stockpile_options_;
+    rng_t::result_type seed_;
+    rng_t rng_;
+    Time turn_ = 0;
+    ProbabilityGenerator probability_generator_;
+
+    static thread_local SimulationContext* current_;
+};
+
+#endif /* SIMULATION_CONTEXT_HPP_ */
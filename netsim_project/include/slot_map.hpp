@@ -0,0 +1,150 @@
+#ifndef SLOT_MAP_HPP_
+#define SLOT_MAP_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+// Uchwyt do elementu SlotMap: numer slotu + generacja. Po usunięciu elementu slot dostaje nową
+// generację, więc stare uchwyty przestają pasować, nawet gdy slot zostanie ponownie zajęty.
+struct SlotHandle {
+    std::uint32_t index = 0;
+    std::uint32_t generation = 0;
+
+    bool operator==(const SlotHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+// Elementy leżą w blokach stałego rozmiaru, które nigdy nie są przenoszone -- adresy pozostają ważne
+// aż do usunięcia elementu (na nich opierają się połączenia IPackageReceiver*).
+// Kolejne elementy tablicy `dense()` wskazują zajęte sloty w kolejności wstawiania; usuwanie tę kolejność zachowuje,
+// więc te same edycje dają zawsze tę samą kolejność iteracji.
+template <class T>
+class SlotMap {
+public:
+    SlotMap() = default;
+    SlotMap(const SlotMap&) = delete;
+    SlotMap& operator=(const SlotMap&) = delete;
+    SlotMap(SlotMap&&) = default;
+    SlotMap& operator=(SlotMap&&) = default;
+
+    void reserve(std::size_t n) {
+        blocks_.reserve((n + block_size_ - 1) / block_size_);
+        dense_.reserve(n);
+        dense_slots_.reserve(n);
+    }
+
+    SlotHandle insert(T&& value) {
+        std::uint32_t index;
+        if (!free_.empty()) {
+            index = free_.back();
+            free_.pop_back();
+        } else {
+            index = slot_count_++;
+            if (index / block_size_ >= blocks_.size()) {
+                blocks_.emplace_back(new Slot[block_size_]);
+            }
+        }
+
+        Slot& slot = slot_at(index);
+        slot.value.emplace(std::move(value));
+        slot.dense = dense_.size();
+        dense_.push_back(&*slot.value);
+        dense_slots_.push_back(index);
+        return SlotHandle{index, slot.generation};
+    }
+
+    // Przesuwa o jedno miejsce elementy `dense()` leżące za usuniętym: koszt proporcjonalny do ich liczby
+    // (same wskaźniki, elementy nie są przenoszone). Wiele elementów naraz -- `erase_if()`.
+    void erase(SlotHandle handle) {
+        if (!contains(handle)) {
+            return;
+        }
+        Slot& slot = slot_at(handle.index);
+        auto position = slot.dense;
+        dense_.erase(dense_.begin() + std::ptrdiff_t(position));
+        dense_slots_.erase(dense_slots_.begin() + std::ptrdiff_t(position));
+        for (auto i = position; i < dense_slots_.size(); ++i) {
+            slot_at(dense_slots_[i]).dense = i;
+        }
+
+        slot.value.reset();
+        ++slot.generation;
+        free_.push_back(handle.index);
+    }
+
+    // Usuwa wszystkie elementy spełniające `pred` jednym przejściem po tablicy `dense()`, zachowując kolejność pozostałych.
+    template <typename Pred>
+    void erase_if(Pred pred) {
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < dense_.size(); ++i) {
+            auto index = dense_slots_[i];
+            Slot& slot = slot_at(index);
+            if (pred(*slot.value)) {
+                slot.value.reset();
+                ++slot.generation;
+                free_.push_back(index);
+            } else {
+                dense_[kept] = dense_[i];
+                dense_slots_[kept] = index;
+                slot.dense = kept++;
+            }
+        }
+        dense_.resize(kept);
+        dense_slots_.resize(kept);
+    }
+
+    void clear() {
+        for (auto index : dense_slots_) {
+            Slot& slot = slot_at(index);
+            slot.value.reset();
+            ++slot.generation;
+            free_.push_back(index);
+        }
+        dense_.clear();
+        dense_slots_.clear();
+    }
+
+    bool contains(SlotHandle handle) const {
+        return handle.index < slot_count_ && slot_at(handle.index).generation == handle.generation
+               && slot_at(handle.index).value.has_value();
+    }
+
+    T* get(SlotHandle handle) { return contains(handle) ? &*slot_at(handle.index).value : nullptr; }
+    const T* get(SlotHandle handle) const { return contains(handle) ? &*slot_at(handle.index).value : nullptr; }
+
+    // Pozycja elementu w tablicy `dense()`.
+    std::size_t position(SlotHandle handle) const {
+        if (!contains(handle)) {
+            throw std::out_of_range("Stale slot handle");
+        }
+        return slot_at(handle.index).dense;
+    }
+
+    const std::vector<T*>& dense() const { return dense_; }
+    std::size_t size() const { return dense_.size(); }
+    bool empty() const { return dense_.empty(); }
+
+private:
+    static constexpr std::uint32_t block_size_ = 64;
+
+    struct Slot {
+        std::optional<T> value;
+        std::uint32_t generation = 0;
+        std::size_t dense = 0;
+    };
+
+    Slot& slot_at(std::uint32_t index) { return blocks_[index / block_size_][index % block_size_]; }
+    const Slot& slot_at(std::uint32_t index) const { return blocks_[index / block_size_][index % block_size_]; }
+
+    std::vector<std::unique_ptr<Slot[]>> blocks_;
+    std::vector<T*> dense_;
+    std::vector<std::uint32_t> dense_slots_;
+    std::vector<std::uint32_t> free_;
+    std::uint32_t slot_count_ = 0;
+};
+
+#endif /* SLOT_MAP_HPP_ */
@@ -0,0 +1,182 @@
+#ifndef SMALL_FLAT_MAP_HPP_
+#define SMALL_FLAT_MAP_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Mapa na ciągłej tablicy par, w kolejności wstawiania. Do `InlineCapacity` elementów mieści się w samym obiekcie,
+// większe przenoszone są na stertę. Wyszukiwanie jest liniowe, a od `indexed_from` elementów -- przez indeks mieszający.
+// Usunięcie przenosi ostatni element na miejsce usuniętego.
+template <class Key, class Value, std::size_t InlineCapacity = 4>
+class SmallFlatMap {
+public:
+    using value_type = std::pair<Key, Value>;
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+
+    static constexpr std::size_t inline_capacity = InlineCapacity;
+    static constexpr std::size_t indexed_from = 16;
+
+    SmallFlatMap() = default;
+    SmallFlatMap(const SmallFlatMap& other) { *this = other; }
+    SmallFlatMap(SmallFlatMap&& other) noexcept { *this = std::move(other); }
+
+    SmallFlatMap& operator=(const SmallFlatMap& other) {
+        if (this != &other) {
+            clear();
+            reserve(other.size());
+            for (const auto& entry : other) {
+                push_back(entry);
+            }
+        }
+        return *this;
+    }
+
+    SmallFlatMap& operator=(SmallFlatMap&& other) noexcept {
+        if (this != &other) {
+            inline_ = std::move(other.inline_);
+            heap_ = std::move(other.heap_);
+            index_ = std::move(other.index_);
+            size_ = other.size_;
+            capacity_ = other.capacity_;
+            other.size_ = 0;
+            other.capacity_ = InlineCapacity;
+        }
+        return *this;
+    }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + size_; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size_; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool is_inline() const { return !heap_; }
+
+    void reserve(std::size_t n) {
+        if (n > InlineCapacity) {
+            spill(n);
+        }
+    }
+
+    iterator find(const Key& key) { return begin() + position(key); }
+    const_iterator find(const Key& key) const { return begin() + position(key); }
+    std::size_t count(const Key& key) const { return position(key) != size_ ? 1 : 0; }
+
+    Value& at(const Key& key) {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("SmallFlatMap::at");
+        }
+        return it->second;
+    }
+    const Value& at(const Key& key) const { return const_cast<SmallFlatMap&>(*this).at(key); }
+
+    Value& operator[](const Key& key) { return emplace(key, Value()).first->second; }
+
+    std::pair<iterator, bool> emplace(const Key& key, const Value& value) {
+        auto it = find(key);
+        if (it != end()) {
+            return {it, false};
+        }
+        push_back({key, value});
+        return {end() - 1, true};
+    }
+
+    std::pair<iterator, bool> insert_or_assign(const Key& key, const Value& value) {
+        auto result = emplace(key, value);
+        result.first->second = value;
+        return result;
+    }
+
+    std::size_t erase(const Key& key) {
+        auto i = position(key);
+        if (i == size_) {
+            return 0;
+        }
+        auto last = size_ - 1;
+        if (index_) {
+            index_->erase(key);
+            if (i != last) {
+                (*index_)[data()[last].first] = i;
+            }
+        }
+        if (i != last) {
+            data()[i] = std::move(data()[last]);
+        }
+        --size_;
+        return 1;
+    }
+
+    void clear() {
+        heap_.reset();
+        index_.reset();
+        size_ = 0;
+        capacity_ = InlineCapacity;
+    }
+
+private:
+    value_type* data() { return heap_ ? heap_.get() : inline_.data(); }
+    const value_type* data() const { return heap_ ? heap_.get() : inline_.data(); }
+
+    std::size_t position(const Key& key) const {
+        if (index_) {
+            auto it = index_->find(key);
+            return it != index_->end() ? it->second : size_;
+        }
+        auto entries = data();
+        for (std::size_t i = 0; i < size_; ++i) {
+            if (entries[i].first == key) {
+                return i;
+            }
+        }
+        return size_;
+    }
+
+    void spill(std::size_t capacity) {
+        if (capacity <= capacity_) {
+            return;
+        }
+        auto entries = std::make_unique<value_type[]>(capacity);
+        std::copy(data(), data() + size_, entries.get());
+        heap_ = std::move(entries);
+        capacity_ = static_cast<std::uint32_t>(capacity);
+    }
+
+    void push_back(const value_type& entry) {
+        if (size_ == capacity_) {
+            spill(2 * std::size_t(capacity_));
+        }
+        data()[size_] = entry;
+        ++size_;
+
+        if (index_) {
+            index_->emplace(entry.first, size_ - 1);
+        } else if (size_ >= indexed_from) {
+            index_ = std::make_unique<std::unordered_map<Key, std::size_t>>();
+            index_->reserve(size_);
+            for (std::size_t i = 0; i < size_; ++i) {
+                index_->emplace(data()[i].first, i);
+            }
+        }
+    }
+
+    std::array<value_type, InlineCapacity> inline_{};
+    // Po przeniesieniu na stertę zawiera wszystkie elementy; nie wraca już do `inline_`.
+    std::unique_ptr<value_type[]> heap_;
+    std::unique_ptr<std::unordered_map<Key, std::size_t>> index_;
+    std::uint32_t size_ = 0;
+    std::uint32_t capacity_ = InlineCapacity;
+};
+
+#endif /* SMALL_FLAT_MAP_HPP_ */
@@ -2,28 +2,116 @@
 #define STORAGE_TYPES_HPP_
 
 #include "package.hpp"
+#include "package_slab.hpp"
 #include "types.hpp"
-#include <list>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SimulationContext;
 
 enum class PackageQueueType {
     FIFO,
-    LIFO
+    LIFO,
+    PRIORITY
 };
 
+// Magazyn półproduktów udostępnia zawartość porcjami: iterator pobiera przez `read()`
+// kolejne fragmenty do własnego bufora, więc nie zależy od sposobu przechowywania
+// (bufor cykliczny, mapa bitowa, plik na dysku...). Bufor zmienia się przy każdym doczytaniu,
+// dlatego iterator jest jednoprzebiegowy i zwraca widoki półproduktów przez wartość.
+// Stan odczytu trzyma iterator, więc wiele iteratorów (także w różnych wątkach) może czytać
+// ten sam zapas; zmiana zawartości unieważnia iteratory.
 class IPackageStockpile {
 public:
-    using const_iterator = std::list<Package>::const_iterator;
+    // Miejsce, w którym skończył się poprzedni odczyt -- pozwala implementacjom czytać kolejne
+    // porcje bez przeliczania od początku. Należy do czytającego (np. iteratora), nie do zapasu,
+    // więc współbieżne odczyty się nie zakłócają.
+    struct ReadCursor {
+        std::size_t segment = 0;
+        std::size_t segment_begin = 0;
+    };
+
+    class const_iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = PackageView;
+        using difference_type = std::ptrdiff_t;
+        using reference = PackageView;
+        struct pointer {
+            PackageView value;
+            const PackageView* operator->() const { return &value; }
+        };
+
+        const_iterator() = default;
+        const_iterator(const IPackageStockpile* stockpile, std::size_t position) : stockpile_(stockpile), position_(position) {}
+
+        reference operator*() const {
+            if (position_ - chunk_begin_ >= chunk_size_) {
+                chunk_begin_ = position_;
+                chunk_size_ = stockpile_->read(position_, chunk_, chunk_capacity, cursor_);
+            }
+            return chunk_[position_ - chunk_begin_];
+        }
+        pointer operator->() const { return {**this}; }
+
+        const_iterator& operator++() { ++position_; return *this; }
+        const_iterator operator++(int) { auto it = *this; ++position_; return it; }
+
+        bool operator==(const const_iterator& other) const { return stockpile_ == other.stockpile_ && position_ == other.position_; }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        static constexpr std::size_t chunk_capacity = 16;
+
+        const IPackageStockpile* stockpile_ = nullptr;
+        std::size_t position_ = 0;
+        mutable std::size_t chunk_begin_ = 0;
+        mutable std::size_t chunk_size_ = 0;
+        mutable ReadCursor cursor_;
+        mutable PackageView chunk_[chunk_capacity];
+    };
 
     virtual void push(Package&& package) = 0;
 
-    virtual const_iterator cbegin() const = 0;
-    virtual const_iterator cend() const = 0;
-    virtual const_iterator begin() const = 0;
-    virtual const_iterator end() const = 0;
+    // Kopiuje do `out` co najwyżej `count` półproduktów, począwszy od pozycji `position`;
+    // zwraca liczbę skopiowanych. Kolejność zależy od implementacji: kolejki FIFO/LIFO zwracają
+    // półprodukty w kolejności wyjmowania, a kolejka priorytetowa -- w kolejności kopca.
+    virtual std::size_t read(std::size_t position, PackageView* out, std::size_t count) const = 0;
+    // Jak wyżej, z kursorem poprzedniego odczytu; domyślnie kursor jest pomijany.
+    virtual std::size_t read(std::size_t position, PackageView* out, std::size_t count, ReadCursor&) const {
+        return read(position, out, count);
+    }
+
+    const_iterator cbegin() const { return const_iterator(this, 0); }
+    const_iterator cend() const { return const_iterator(this, size()); }
+    const_iterator begin() const { return cbegin(); }
+    const_iterator end() const { return cend(); }
 
     virtual std::size_t size() const = 0;
     virtual bool empty() const = 0;
+    // Czy iteracja zwraca półprodukty w kolejności rosnących ID.
+    virtual bool is_sorted() const { return false; }
+    // Kontekst, do którego wracają ID półproduktów niszczonych razem z magazynem.
+    SimulationContext& context() const { return *context_; }
+    // Przenosi pusty zapas do innego kontekstu; rzuca std::logic_error, jeśli zapas przechowuje półprodukty.
+    virtual void bind(SimulationContext& context);
     virtual ~IPackageStockpile() = default;
+
+protected:
+    // Bez podanego kontekstu -- kontekst bieżący z chwili utworzenia.
+    IPackageStockpile();
+    explicit IPackageStockpile(SimulationContext& context) : context_(&context) {}
+
+    // Zwalnia ID przechowywanego półproduktu w kontekście magazynu, niezależnie od kontekstu bieżącego.
+    void release_stored(ElementID id) const noexcept;
+
+private:
+    SimulationContext* context_;
 };
 
 class IPackageQueue: public IPackageStockpile {
@@ -31,27 +119,211 @@ public:
     virtual Package pop() = 0;
     virtual PackageQueueType get_queue_type() const = 0;
     ~IPackageQueue() override = default;
+
+protected:
+    IPackageQueue() = default;
+    explicit IPackageQueue(SimulationContext& context) : IPackageStockpile(context) {}
 };
 
-class PackageQueue: public IPackageQueue {
+// Kolejka FIFO/LIFO na rosnącym buforze cyklicznym: przechowuje jedynie 32-bitowe uchwyty,
+// bez alokacji na pojedynczy półprodukt.
+class PackageQueue final: public IPackageQueue {
 public:
-    explicit PackageQueue(PackageQueueType queue_type) : queue_(), queue_type_(queue_type) {}
-    void push(Package&& package) override { queue_.emplace_back(std::move(package)); }
-    std::size_t size() const override { return queue_.size(); }
-    bool empty() const override { return queue_.empty(); }
+    explicit PackageQueue(PackageQueueType queue_type);
+    PackageQueue(PackageQueueType queue_type, SimulationContext& context);
+    PackageQueue(const PackageQueue&) = delete;
+    PackageQueue& operator=(const PackageQueue&) = delete;
 
-    const_iterator cbegin() const override { return queue_.cbegin(); }
-    const_iterator cend() const override { return queue_.cend(); }
-    const_iterator begin() const override { return queue_.cbegin(); }
-    const_iterator end() const override { return queue_.cend(); }
+    void push(Package&& package) override {
+        if (size_ == queue_.size()) {
+            grow();
+        }
+        queue_[(head_ + size_) & mask()] = package.release_handle();
+        ++size_;
+    }
+    std::size_t size() const override { return size_; }
+    bool empty() const override { return size_ == 0; }
+
+    std::size_t read(std::size_t position, PackageView* out, std::size_t count) const override;
+
+    Package pop() override { return queue_type_ == PackageQueueType::LIFO ? pop_back() : pop_front(); }
+    Package pop_front() {
+        ElementID id = queue_[head_];
+        head_ = (head_ + 1) & mask();
+        --size_;
+        return Package::adopt_handle(id);
+    }
+    Package pop_back() {
+        --size_;
+        return Package::adopt_handle(queue_[(head_ + size_) & mask()]);
+    }
 
-    Package pop() override;
     PackageQueueType get_queue_type() const override { return queue_type_; }
-    ~PackageQueue() override = default;
+    ~PackageQueue() override;
 
 private:
-    std::list<Package> queue_;
+    std::size_t mask() const { return queue_.size() - 1; }
+    void grow();
+
+    std::vector<ElementID> queue_;
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
     PackageQueueType queue_type_;
 };
 
-#endif /* STORAGE_TYPES_HPP_ */
\ No newline at end of file
+// Kolejka priorytetowa (kopiec 4-arny): jako pierwszy wychodzi półprodukt o najmniejszej
+// wartości atrybutu `key` (domyślnie najstarszy), przy remisie -- o najmniejszym ID.
+// Atrybut odczytywany jest w chwili wstawienia z kontekstu kolejki. Iteracja przechodzi kopiec
+// w kolejności tablicy, nie wyjmowania -- tę daje `in_pop_order()`.
+class PriorityPackageQueue final: public IPackageQueue {
+public:
+    explicit PriorityPackageQueue(PackageAttribute key = PackageAttribute::CREATION_TURN);
+    PriorityPackageQueue(PackageAttribute key, SimulationContext& context);
+    PriorityPackageQueue(const PriorityPackageQueue&) = delete;
+    PriorityPackageQueue& operator=(const PriorityPackageQueue&) = delete;
+
+    void push(Package&& package) override;
+    std::size_t read(std::size_t position, PackageView* out, std::size_t count) const override;
+    std::size_t size() const override { return heap_.size(); }
+    bool empty() const override { return heap_.empty(); }
+
+    Package pop() override;
+    PackageQueueType get_queue_type() const override { return PackageQueueType::PRIORITY; }
+    PackageAttribute get_key() const { return key_; }
+    // Posortowana kopia zawartości w kolejności, w jakiej wyjmowałby ją `pop()`; O(n log n).
+    std::vector<PackageView> in_pop_order() const;
+    void bind(SimulationContext& context) override;
+    ~PriorityPackageQueue() override;
+
+private:
+    static constexpr std::size_t arity = 4;
+
+    struct Entry {
+        std::int64_t key;
+        ElementID id;
+        bool operator<(const Entry& other) const { return key < other.key || (key == other.key && id < other.id); }
+    };
+
+    std::int64_t key_of(ElementID id) const;
+
+    PackageAttribute key_;
+    std::vector<Entry> heap_;
+};
+
+// Zapas magazynu jako skompresowana mapa bitowa ID (w stylu "roaring"): ID dzielone jest na
+// 16 starszych bitów (numer kontenera) i 16 młodszych. Kontener przechowuje młodsze bity
+// w posortowanej tablicy, a po przekroczeniu 4096 elementów -- w mapie bitowej 8 KB.
+// Wstawienie rosnącego ID (dopisanie) lub do mapy bitowej kosztuje O(1); ID spoza kolejności przesuwa
+// do 4096 elementów tablicy kontenera. Iteracja zwraca ID rosnąco.
+class BitmapStockpile final: public IPackageStockpile {
+public:
+    BitmapStockpile() = default;
+    explicit BitmapStockpile(SimulationContext& context) : IPackageStockpile(context) {}
+    BitmapStockpile(const BitmapStockpile&) = delete;
+    BitmapStockpile& operator=(const BitmapStockpile&) = delete;
+
+    // Rzuca std::logic_error, gdy półprodukt o tym ID już jest w zapasie (półprodukt pozostaje u wywołującego).
+    void push(Package&& package) override;
+    std::size_t read(std::size_t position, PackageView* out, std::size_t count) const override;
+    // Kursor wskazuje kontener, w którym skończył się poprzedni odczyt.
+    std::size_t read(std::size_t position, PackageView* out, std::size_t count, ReadCursor& cursor) const override;
+    std::size_t size() const override { return size_; }
+    bool empty() const override { return size_ == 0; }
+    bool is_sorted() const override { return true; }
+
+    std::size_t bytes_used() const;
+    ~BitmapStockpile() override;
+
+private:
+    static constexpr std::size_t array_limit = 4096;
+    static constexpr std::size_t bitmap_words = 1024;
+
+    struct Container {
+        std::vector<std::uint16_t> array;
+        std::vector<std::uint64_t> bitmap;
+        std::size_t cardinality = 0;
+
+        bool contains(std::uint16_t low) const;
+        bool insert(std::uint16_t low);
+        std::size_t read(std::size_t rank, ElementID base, PackageView* out, std::size_t count) const;
+    };
+
+    std::vector<Container> containers_;
+    std::size_t size_ = 0;
+};
+
+// Zapas magazynu na bardzo długie symulacje: najnowsze ID trzymane są w pamięci (ogon),
+// a po zapełnieniu ogona dopisywane do pliku w katalogu `directory`, czytanego przez mmap.
+// Iteracja zachowuje kolejność przyjęcia. Plik usuwany jest razem z obiektem.
+class LogStockpile final: public IPackageStockpile {
+public:
+    explicit LogStockpile(const std::string& directory, std::size_t tail_capacity = 4096);
+    LogStockpile(const std::string& directory, std::size_t tail_capacity, SimulationContext& context);
+    LogStockpile(const LogStockpile&) = delete;
+    LogStockpile& operator=(const LogStockpile&) = delete;
+
+    void push(Package&& package) override;
+    std::size_t read(std::size_t position, PackageView* out, std::size_t count) const override;
+    std::size_t size() const override { return spilled_ + tail_.size(); }
+    bool empty() const override { return size() == 0; }
+
+    std::size_t spilled_size() const { return spilled_; }
+    const std::string& get_path() const { return path_; }
+    ~LogStockpile() override;
+
+private:
+    void spill();
+    void unmap() const;
+
+    std::string path_;
+    int fd_;
+    std::size_t tail_capacity_;
+    std::vector<ElementID> tail_;
+    std::size_t spilled_ = 0;
+    mutable const ElementID* mapped_ = nullptr;
+    mutable std::size_t mapped_size_ = 0;
+};
+
+// Dyscypliny kolejek jako polityki czasu kompilacji: `queue_t` to faktyczny typ kolejki,
+// więc push/pop/size wywoływane są bez dyspozycji wirtualnej. `VirtualDiscipline` obsługuje
+// dowolną implementację IPackageQueue.
+struct FifoDiscipline {
+    using queue_t = PackageQueue;
+    static Package pop(queue_t& q) { return q.pop_front(); }
+};
+
+struct LifoDiscipline {
+    using queue_t = PackageQueue;
+    static Package pop(queue_t& q) { return q.pop_back(); }
+};
+
+struct PriorityDiscipline {
+    using queue_t = PriorityPackageQueue;
+    static Package pop(queue_t& q) { return q.pop(); }
+};
+
+struct VirtualDiscipline {
+    using queue_t = IPackageQueue;
+    static Package pop(queue_t& q) { return q.pop(); }
+};
+
+enum class StockpileType {
+    QUEUE, BITMAP, LOG
+};
+
+// Domyślny sposób przechowywania zapasu magazynów -- ustawiany dla całej symulacji w `SimulationContext`.
+struct StockpileOptions {
+    StockpileType type = StockpileType::QUEUE;
+    // Pusty -- katalog tymczasowy systemu (std::filesystem::temp_directory_path()).
+    std::string spill_directory;
+    std::size_t tail_capacity = 4096;
+};
+
+// Bez podanego kontekstu -- kontekst bieżący.
+std::unique_ptr<IPackageQueue> make_package_queue(PackageQueueType queue_type);
+std::unique_ptr<IPackageQueue> make_package_queue(PackageQueueType queue_type, SimulationContext& context);
+std::unique_ptr<IPackageStockpile> make_stockpile(StockpileType type, const StockpileOptions& options);
+std::unique_ptr<IPackageStockpile> make_stockpile(StockpileType type, const StockpileOptions& options,
+                                                  SimulationContext& context);
+
+#endif /* STORAGE_TYPES_HPP_ */
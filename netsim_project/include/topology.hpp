@@ -0,0 +1,119 @@
+#ifndef TOPOLOGY_HPP_
+#define TOPOLOGY_HPP_
+
+#include "nodes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Indeks odwrotny połączeń: odbiorca -> nadawcy, którzy mają go w preferencjach.
+// Po aktualizacji indeksu zdarzenie przekazywane jest dalej do obserwatora z `chain()`.
+class SenderIndex : public IReceiverPreferencesObserver {
+public:
+    void on_receiver_added(PackageSender& sender, IPackageReceiver* receiver) override;
+    void on_receiver_removed(PackageSender& sender, IPackageReceiver* receiver) override;
+
+    void chain(IReceiverPreferencesObserver* next) { next_ = next; }
+
+    const std::vector<PackageSender*>& get_senders(const IPackageReceiver* receiver) const;
+    // Odłącza wpis odbiorcy i zwraca jego nadawców.
+    std::vector<PackageSender*> take_senders(const IPackageReceiver* receiver);
+    void clear() {
+        senders_.clear();
+        positions_.clear();
+    }
+
+private:
+    struct Edge {
+        const PackageSender* sender;
+        const IPackageReceiver* receiver;
+        bool operator==(const Edge& other) const { return sender == other.sender && receiver == other.receiver; }
+    };
+    struct EdgeHash {
+        std::size_t operator()(const Edge& edge) const {
+            auto h = std::hash<const void*>()(edge.sender);
+            return h ^ (std::hash<const void*>()(edge.receiver) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+        }
+    };
+
+    std::unordered_map<const IPackageReceiver*, std::vector<PackageSender*>> senders_;
+    // Pozycja nadawcy na liście odbiorcy -- odłączenie krawędzi w O(1), bez przeszukiwania listy.
+    std::unordered_map<Edge, std::size_t, EdgeHash> positions_;
+    IReceiverPreferencesObserver* next_ = nullptr;
+};
+
+
+// Utrzymuje przyrostowo, dla każdego nadawcy fabryki, odległość od najbliższej rampy i do najbliższego magazynu
+// (dynamiczne najkrótsze ścieżki w stylu Ramalingama-Repsa). Zmiana połączenia przelicza tylko węzły,
+// których odległość od niej zależy; liczba nadawców osiągalnych z ramp, a bez drogi do magazynu, jest znana w O(1).
+class ReachabilityTracker : public IReceiverPreferencesObserver {
+public:
+    explicit ReachabilityTracker(const SenderIndex& senders) : senders_(&senders) {}
+
+    void add_sender(PackageSender& sender, const IPackageReceiver* as_receiver, bool is_ramp);
+    void remove_sender(const PackageSender& sender);
+    void add_storehouse(const IPackageReceiver& storehouse);
+    void remove_storehouse(const IPackageReceiver& storehouse);
+
+    void on_receiver_added(PackageSender& sender, IPackageReceiver* receiver) override;
+    void on_receiver_removed(PackageSender& sender, IPackageReceiver* receiver) override;
+
+    // Wyłączony tracker ignoruje zmiany połączeń; `rebuild()` przelicza wszystko w O(V + E) i go włącza.
+    void disable() { enabled_ = false; }
+    void rebuild();
+    void clear();
+
+    std::size_t offender_count() const { return offenders_; }
+    bool is_reachable(const PackageSender& sender) const;
+
+private:
+    using distance_t = std::uint32_t;
+    static constexpr distance_t unreachable_ = std::numeric_limits<distance_t>::max();
+
+    enum class Direction {
+        TO_STOREHOUSE, FROM_RAMP
+    };
+
+    struct NodeState {
+        PackageSender* sender;
+        const IPackageReceiver* as_receiver;
+        bool is_ramp;
+        std::size_t storehouse_links = 0;
+        distance_t to_storehouse = unreachable_;
+        distance_t from_ramp = unreachable_;
+        bool offender = false;
+    };
+
+    NodeState* find_state(const PackageSender* sender);
+    NodeState* find_worker_state(const IPackageReceiver* receiver);
+
+    distance_t& distance(NodeState& node, Direction direction);
+    distance_t base_distance(const NodeState& node, Direction direction) const;
+    void set_distance(NodeState& node, Direction direction, distance_t value);
+
+    // Węzły, od których zależy odległość `node` (następniki w kierunku magazynu, poprzedniki w kierunku rampy)...
+    template <typename F>
+    void for_each_support(NodeState& node, Direction direction, F f);
+    // ...i węzły, których odległość zależy od `node`.
+    template <typename F>
+    void for_each_dependent(NodeState& node, Direction direction, F f);
+
+    bool is_supported(NodeState& node, Direction direction, const std::unordered_set<NodeState*>& affected);
+    void propagate(std::vector<NodeState*> seeds, Direction direction);
+    void decrease(NodeState& node, Direction direction);
+    void increase(NodeState& node, Direction direction);
+
+    const SenderIndex* senders_;
+    std::unordered_map<const PackageSender*, NodeState> nodes_;
+    std::unordered_map<const IPackageReceiver*, NodeState*> workers_;
+    std::unordered_set<const IPackageReceiver*> storehouses_;
+    std::size_t offenders_ = 0;
+    bool enabled_ = true;
+};
+
+#endif /* TOPOLOGY_HPP_ */
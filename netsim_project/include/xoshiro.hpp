@@ -0,0 +1,48 @@
+#ifndef XOSHIRO_HPP_
+#define XOSHIRO_HPP_
+
+#include <cstdint>
+#include <limits>
+
+// xoshiro256++ (Blackman, Vigna): 32 bajty stanu, kilka operacji na liczbę -- w całości rozwijany w miejscu wywołania.
+// Spełnia wymagania UniformRandomBitGenerator, więc współpracuje z rozkładami z <random>.
+class Xoshiro256PlusPlus {
+public:
+    using result_type = std::uint64_t;
+
+    // Stan wypełniany przez splitmix64, jak zalecają autorzy -- każde ziarno (także 0) daje poprawny stan.
+    explicit Xoshiro256PlusPlus(std::uint64_t seed = 0) {
+        for (auto& word : s_) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            auto z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        auto result = rotl(s_[0] + s_[3], 23) + s_[0];
+        auto t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+
+    // Liczba z [0, 1) z 53 najstarszych bitów.
+    double canonical() { return double((*this)() >> 11) * 0x1.0p-53; }
+
+private:
+    static result_type rotl(result_type x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    result_type s_[4];
+};
+
+#endif /* XOSHIRO_HPP_ */
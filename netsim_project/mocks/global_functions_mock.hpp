@@ -5,7 +5,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
-#include "helpers.hpp"
+#include "simulation_context.hpp"
 
 // -------
 
@@ -28,11 +28,11 @@ class GlobalFunctionsFixture : public ::testing::Test {
 public:
     #ifdef WITH_PROBABILITY_GENERATOR
     GlobalFunctionsFixture() {
-        probability_generator = [&]() { return global_functions_mock.generate_canonical(); };
+        SimulationContext::current().set_probability_generator([&]() { return global_functions_mock.generate_canonical(); });
     }
 
     ~GlobalFunctionsFixture() override {
-        probability_generator = default_probability_generator;
+        SimulationContext::current().reset_probability_generator();
     }
     #endif
 
@@ -0,0 +1,45 @@
+#include "alias_table.hpp"
+
+#include <numeric>
+
+void build_alias_table(const std::vector<double>& weights, std::vector<AliasColumn>& columns) {
+    columns.resize(weights.size());
+    std::vector<std::uint32_t> worklist(weights.size());
+    build_alias_table(weights.data(), weights.size(), columns.data(), worklist.data());
+}
+
+void build_alias_table(const double* weights, std::size_t n, AliasColumn* columns, std::uint32_t* worklist) {
+    double total = std::accumulate(weights, weights + n, 0.0);
+
+    // Przeskalowane wagi trzymane są w samych kolumnach; stos "małych" rośnie od początku `worklist`,
+    // stos "dużych" -- od końca (razem nigdy nie przekraczają n).
+    std::size_t small = 0;
+    std::size_t large = 0;
+    for (std::uint32_t i = 0; i < n; ++i) {
+        double scaled = total > 0 ? weights[i] * double(n) / total : 1.0;
+        columns[i] = {scaled, i};
+        if (scaled < 1.0) {
+            worklist[small++] = i;
+        } else {
+            worklist[n - ++large] = i;
+        }
+    }
+
+    while (small > 0 && large > 0) {
+        auto s = worklist[--small];
+        auto l = worklist[n - large];
+        columns[s].alias = l;
+        columns[l].probability = (columns[l].probability + columns[s].probability) - 1.0;
+        if (columns[l].probability < 1.0) {
+            --large;
+            worklist[small++] = l;
+        }
+    }
+    // To, co zostało (również przez błędy zaokrągleń), wybiera zawsze samo siebie.
+    for (std::size_t k = 0; k < small; ++k) {
+        columns[worklist[k]] = {1.0, worklist[k]};
+    }
+    for (std::size_t k = 0; k < large; ++k) {
+        columns[worklist[n - 1 - k]] = {1.0, worklist[n - 1 - k]};
+    }
+}
@@ -0,0 +1,96 @@
+#include "execution_graph.hpp"
+
+#include <algorithm>
+
+void ExecutionGraph::do_deliveries(Time time) {
+    SimulationContext::Scope scope(*context_);
+    context_->set_turn(time);
+    for (auto ramp : ramps_) {
+        ramp->deliver_goods(time);
+    }
+}
+
+void ExecutionGraph::do_package_passing() {
+    SimulationContext::Scope scope(*context_);
+    for (std::size_t sender = 0; sender < senders_.size(); ++sender) {
+        send_package(sender);
+    }
+}
+
+template <class Discipline>
+void ExecutionGraph::work(const std::vector<Worker*>& workers, Time time) {
+    for (auto worker : workers) {
+        worker->do_work_as<Discipline>(time);
+    }
+}
+
+void ExecutionGraph::do_work(Time time) {
+    SimulationContext::Scope scope(*context_);
+    work<FifoDiscipline>(fifo_workers_, time);
+    work<LifoDiscipline>(lifo_workers_, time);
+    work<PriorityDiscipline>(priority_workers_, time);
+    work<VirtualDiscipline>(other_workers_, time);
+}
+
+ReceiverHandle ExecutionGraph::choose_receiver(std::size_t sender) {
+    auto first = offsets_[sender];
+    auto count = offsets_[sender + 1] - first;
+    if (count == 1) {
+        return targets_[first];
+    }
+    // Losowanie ze strumienia nadawcy -- te same liczby co w ReceiverPreferences::choose_receiver().
+    auto prob = senders_[sender]->receiver_preferences_.draw_probability();
+    return targets_[first + alias_pick(&alias_table_[first], count, prob)];
+}
+
+template <class Discipline>
+void ExecutionGraph::hand_to_worker(Worker& worker, std::optional<Package>& buffer) {
+    if (!worker.can_receive_as<Discipline>()) {
+        return;
+    }
+    context_->packages().count_hop(buffer->get_id());
+    worker.receive_as<Discipline>(std::move(*buffer));
+    buffer.reset();
+}
+
+std::size_t ExecutionGraph::virtual_edge_count() const {
+    return std::size_t(std::count_if(targets_.begin(), targets_.end(), [](ReceiverHandle target) {
+        return target.kind() == ReceiverHandle::Kind::OTHER_WORKER || target.kind() == ReceiverHandle::Kind::OTHER_STOREHOUSE;
+    }));
+}
+
+void ExecutionGraph::send_package(std::size_t sender) {
+    auto& buffer = senders_[sender]->bufor_;
+    if (!buffer || offsets_[sender] == offsets_[sender + 1]) {
+        return;
+    }
+
+    auto receiver = choose_receiver(sender);
+    switch (receiver.kind()) {
+        case ReceiverHandle::Kind::RING_WORKER:
+            // FIFO i LIFO różnią się tylko pobieraniem; wstawianie jest wspólne.
+            hand_to_worker<FifoDiscipline>(*workers_[receiver.index()], buffer);
+            break;
+        case ReceiverHandle::Kind::PRIORITY_WORKER:
+            hand_to_worker<PriorityDiscipline>(*workers_[receiver.index()], buffer);
+            break;
+        case ReceiverHandle::Kind::OTHER_WORKER:
+            hand_to_worker<VirtualDiscipline>(*workers_[receiver.index()], buffer);
+            break;
+        case ReceiverHandle::Kind::RING_STOREHOUSE:
+            context_->packages().count_hop(buffer->get_id());
+            storehouses_[receiver.index()]->receive_as<PackageQueue>(std::move(*buffer));
+            buffer.reset();
+            break;
+        case ReceiverHandle::Kind::BITMAP_STOREHOUSE:
+            context_->packages().count_hop(buffer->get_id());
+            storehouses_[receiver.index()]->receive_as<BitmapStockpile>(std::move(*buffer));
+            buffer.reset();
+            break;
+        case ReceiverHandle::Kind::OTHER_STOREHOUSE:
+            context_->packages().count_hop(buffer->get_id());
+            storehouses_[receiver.index()]->receive_package(std::move(*buffer));
+            buffer.reset();
+            break;
+    }
+}
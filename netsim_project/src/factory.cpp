@@ -1,121 +1,463 @@
 #include "factory.hpp"
+#include "factory_builder.hpp"
 #include "nodes.hpp"
 
+#include <array>
+#include <charconv>
 #include <vector>
 #include <istream>
+#include <list>
 #include <sstream>
+#include <algorithm>
 #include <map>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+Factory::Factory(SimulationContext& context)
+    : context_(&context), senders_(std::make_unique<SenderIndex>()),
+      reachability_(std::make_unique<ReachabilityTracker>(*senders_)) {
+    senders_->chain(reachability_.get());
+}
+
+Factory& Factory::operator=(Factory&& factory) noexcept {
+    if (this != &factory) {
+        clear();
+        context_ = factory.context_;
+        ramp_ = std::move(factory.ramp_);
+        worker_ = std::move(factory.worker_);
+        storehouse_ = std::move(factory.storehouse_);
+        senders_ = std::move(factory.senders_);
+        reachability_ = std::move(factory.reachability_);
+    }
+    return *this;
+}
+
+Factory::~Factory() {
+    clear();
+}
+
+void Factory::clear() {
+    // Półprodukty zwalniają swoje ID w kontekście, z którego zostały przydzielone.
+    SimulationContext::Scope scope(*context_);
+    ramp_.clear();
+    worker_.clear();
+    storehouse_.clear();
+    if (senders_) {
+        senders_->clear();
+        reachability_->clear();
+    }
+}
+
+void Factory::reserve(std::size_t ramps, std::size_t workers, std::size_t storehouses) {
+    ramp_.reserve(ramps);
+    worker_.reserve(workers);
+    storehouse_.reserve(storehouses);
+}
+
+void Factory::attach_sender(PackageSender& sender) {
+    sender.receiver_preferences_.bind(*context_);
+    sender.receiver_preferences_.observe(&sender, senders_.get());
+    for (const auto& preference : sender.receiver_preferences_.get_weights()) {
+        senders_->on_receiver_added(sender, preference.first);
+    }
+}
+
+void Factory::detach_sender(PackageSender& sender) {
+    sender.receiver_preferences_.observe(nullptr, nullptr);
+    for (const auto& preference : sender.receiver_preferences_.get_weights()) {
+        senders_->on_receiver_removed(sender, preference.first);
+    }
+}
+
+void Factory::detach_receiver(IPackageReceiver& receiver) {
+    for (auto sender : senders_->take_senders(&receiver)) {
+        sender->receiver_preferences_.remove_receiver(&receiver);
+    }
+}
 
 //--RAMP--//
 void Factory::add_ramp(Ramp&& ramp) {
-    ramp_.add(std::move(ramp));
+    auto& added = ramp_.add(std::move(ramp));
+    reachability_->add_sender(added, nullptr, true);
+    attach_sender(added);
 }
 
 void Factory::remove_ramp(ElementID id) {
-    ramp_.remove_by_id(id);
+    // Półprodukty usuwanego węzła wracają do kontekstu fabryki.
+    SimulationContext::Scope scope(*context_);
+    auto ramp_it = ramp_.find_by_id(id);
+    if (ramp_it != ramp_.end()) {
+        detach_sender(*ramp_it);
+        reachability_->remove_sender(*ramp_it);
+        ramp_.remove_by_id(id);
+    }
 }
 
 //--WORKER--//
 void Factory::add_worker(Worker&& worker) {
-    worker_.add(std::move(worker));
+    worker.bind(*context_);
+    auto& added = worker_.add(std::move(worker));
+    reachability_->add_sender(added, &added, false);
+    attach_sender(added);
 }
 
 void Factory::remove_worker(ElementID id) {
+    // Półprodukty usuwanego węzła wracają do kontekstu fabryki.
+    SimulationContext::Scope scope(*context_);
     auto worker_it = worker_.find_by_id(id);
-
     if (worker_it != worker_.end()) {
-        Worker& worker = *worker_it;
-
-        for (auto& ramp : ramp_) {
-            ramp.receiver_preferences_.remove_receiver(&worker);
-        }
-
+        detach_sender(*worker_it);
+        detach_receiver(*worker_it);
+        reachability_->remove_sender(*worker_it);
         worker_.remove_by_id(id);
     }
 }
 
 //--STOREHOUSE--//
 void Factory::add_storehouse(Storehouse&& storehouse) {
-    storehouse_.add(std::move(storehouse));
+    storehouse.bind(*context_);
+    reachability_->add_storehouse(storehouse_.add(std::move(storehouse)));
 }
 
 void Factory::remove_storehouse(ElementID id) {
-    storehouse_.remove_by_id(id);
+    // Półprodukty usuwanego węzła wracają do kontekstu fabryki.
+    SimulationContext::Scope scope(*context_);
+    auto storehouse_it = storehouse_.find_by_id(id);
+    if (storehouse_it != storehouse_.end()) {
+        detach_receiver(*storehouse_it);
+        reachability_->remove_storehouse(*storehouse_it);
+        storehouse_.remove_by_id(id);
+    }
 }
 
 
 
-bool is_storehouse_achievable(const PackageSender *node, std::map<const PackageSender *, node_colour> &node_states) {
-    if (node_states[node] == node_colour::CHECKED) {
-        return true;
+ConsistencyReport Factory::check_consistency() const {
+    // Nadawcy numerowani gęsto: rampy 0..R-1, robotnicy R..R+W-1.
+    auto ramp_count = ramp_.size();
+    auto sender_count = ramp_count + worker_.size();
+    std::vector<const PackageSender*> senders;
+    senders.reserve(sender_count);
+    for (const auto& ramp : ramp_) {
+        senders.push_back(&ramp);
+    }
+    for (const auto& worker : worker_) {
+        senders.push_back(&worker);
+    }
+
+    auto worker_index = [this, ramp_count](const IPackageReceiver* receiver) -> std::optional<std::size_t> {
+        auto it = worker_.find_by_id(receiver->get_id());
+        if (it == worker_.cend() || &*it != receiver) {
+            return std::nullopt;
+        }
+        return ramp_count + std::size_t(it - worker_.cbegin());
+    };
+    auto is_own_storehouse = [this](const IPackageReceiver* receiver) {
+        auto it = storehouse_.find_by_id(receiver->get_id());
+        return it != storehouse_.cend() && &*it == receiver;
+    };
+
+    // Krawędzie nadawca -> robotnik (CSR) i nadawcy z bezpośrednim połączeniem z magazynem.
+    std::vector<std::size_t> offsets(sender_count + 1, 0);
+    std::vector<std::size_t> targets;
+    std::vector<bool> reaches_storehouse(sender_count, false);
+    for (std::size_t s = 0; s < sender_count; ++s) {
+        for (const auto& preference : senders[s]->receiver_preferences_.get_weights()) {
+            const IPackageReceiver* receiver = preference.first;
+            if (receiver->get_receiver_type() == ReceiverType::STOREHOUSE) {
+                if (is_own_storehouse(receiver)) {
+                    reaches_storehouse[s] = true;
+                }
+            } else if (auto index = worker_index(receiver); index && *index != s) {
+                targets.push_back(*index);
+            }
+        }
+        offsets[s + 1] = targets.size();
     }
-    node_states[node] = node_colour::VISITED;
 
-    if (node->receiver_preferences_.get_preferences().empty()) {
-        throw std::logic_error("No receivers");
+    // Odwrócone krawędzie, by przejść wstecz od magazynów.
+    std::vector<std::size_t> reverse_offsets(sender_count + 1, 0);
+    for (auto target : targets) {
+        ++reverse_offsets[target + 1];
+    }
+    for (std::size_t s = 0; s < sender_count; ++s) {
+        reverse_offsets[s + 1] += reverse_offsets[s];
+    }
+    std::vector<std::size_t> reverse_targets(targets.size());
+    auto fill = reverse_offsets;
+    for (std::size_t s = 0; s < sender_count; ++s) {
+        for (auto edge = offsets[s]; edge < offsets[s + 1]; ++edge) {
+            reverse_targets[fill[targets[edge]]++] = s;
+        }
     }
 
-    bool has_receiver = false;
-    for (auto &receiver: node->receiver_preferences_.get_preferences()) {
-        if (receiver.first->get_receiver_type() == ReceiverType::STOREHOUSE) {
-            has_receiver = true;
-        } else if (receiver.first->get_receiver_type() == ReceiverType::WORKER) {
-            IPackageReceiver *receiver_ptr = receiver.first;
-            auto worker_ptr = dynamic_cast<Worker *>(receiver_ptr);
-            auto sendrecv_ptr = dynamic_cast<PackageSender *>(worker_ptr);
-            if (sendrecv_ptr == node) {
-                continue;
+    std::vector<std::size_t> stack;
+    for (std::size_t s = 0; s < sender_count; ++s) {
+        if (reaches_storehouse[s]) {
+            stack.push_back(s);
+        }
+    }
+    while (!stack.empty()) {
+        auto s = stack.back();
+        stack.pop_back();
+        for (auto edge = reverse_offsets[s]; edge < reverse_offsets[s + 1]; ++edge) {
+            auto predecessor = reverse_targets[edge];
+            if (!reaches_storehouse[predecessor]) {
+                reaches_storehouse[predecessor] = true;
+                stack.push_back(predecessor);
             }
-            has_receiver = true;
-            if (node_states[sendrecv_ptr] == node_colour::NOT_VISITED) {
-                is_storehouse_achievable(sendrecv_ptr, node_states);
+        }
+    }
+
+    std::vector<bool> reachable(sender_count, false);
+    for (std::size_t s = 0; s < ramp_count; ++s) {
+        reachable[s] = true;
+        stack.push_back(s);
+    }
+    while (!stack.empty()) {
+        auto s = stack.back();
+        stack.pop_back();
+        for (auto edge = offsets[s]; edge < offsets[s + 1]; ++edge) {
+            if (!reachable[targets[edge]]) {
+                reachable[targets[edge]] = true;
+                stack.push_back(targets[edge]);
             }
         }
     }
 
-    node_states[node] = node_colour::CHECKED;
+    ConsistencyReport report;
+    for (std::size_t s = 0; s < sender_count; ++s) {
+        if (!reachable[s]) {
+            report.unreachable_workers.push_back(worker_.cbegin()[std::ptrdiff_t(s - ramp_count)].get_id());
+            continue;
+        }
+        if (reaches_storehouse[s]) {
+            continue;
+        }
+        bool is_ramp = s < ramp_count;
+        ElementID id = is_ramp ? ramp_.cbegin()[std::ptrdiff_t(s)].get_id()
+                               : worker_.cbegin()[std::ptrdiff_t(s - ramp_count)].get_id();
+        auto problem = senders[s]->receiver_preferences_.get_weights().empty()
+                       ? ConsistencyReport::Problem::NO_RECEIVERS
+                       : ConsistencyReport::Problem::NO_PATH_TO_STOREHOUSE;
+        report.offenders.push_back({is_ramp ? ElementType::RAMP : ElementType::WORKER, id, problem});
+    }
+    return report;
+}
+
+PruneReport Factory::prune_unreachable() {
+    PruneReport report;
+    std::unordered_set<const void*> dead;
 
-    if (!has_receiver) {
-        throw std::logic_error("No receiver");
+    for (auto& worker : worker_) {
+        if (!reachability_->is_reachable(worker)) {
+            report.workers.push_back(worker.get_id());
+            dead.insert(&worker);
+        }
+    }
+    for (auto& storehouse : storehouse_) {
+        const auto& senders = senders_->get_senders(&storehouse);
+        bool fed = std::any_of(senders.begin(), senders.end(), [this](const PackageSender* sender) {
+            return reachability_->is_reachable(*sender);
+        });
+        if (!fed) {
+            report.storehouses.push_back(storehouse.get_id());
+            dead.insert(&storehouse);
+        }
+    }
+    if (report.empty()) {
+        return report;
+    }
+
+    for (auto& worker : worker_) {
+        if (dead.count(&worker)) {
+            detach_sender(worker);
+            detach_receiver(worker);
+            reachability_->remove_sender(worker);
+        }
     }
-    return true;
+    for (auto& storehouse : storehouse_) {
+        if (dead.count(&storehouse)) {
+            detach_receiver(storehouse);
+            reachability_->remove_storehouse(storehouse);
+        }
+    }
+
+    SimulationContext::Scope scope(*context_);
+    worker_.remove_if([&dead](const Worker& worker) { return dead.count(&worker) > 0; });
+    storehouse_.remove_if([&dead](const Storehouse& storehouse) { return dead.count(&storehouse) > 0; });
+    return report;
 }
 
-bool Factory::is_consistent() const {
-    std::map<const PackageSender *, node_colour> map;
-    for (const PackageSender &ramp: ramp_) {
-        map[&ramp] = node_colour::NOT_VISITED;
+void Factory::reorder_for_locality() {
+    std::unordered_map<const IPackageReceiver*, Worker*> workers;
+    std::unordered_map<const IPackageReceiver*, Storehouse*> storehouses;
+    for (auto& worker : worker_) {
+        workers.emplace(&worker, &worker);
+    }
+    for (auto& storehouse : storehouse_) {
+        storehouses.emplace(&storehouse, &storehouse);
     }
 
-    for (const PackageSender &worker: worker_) {
-        map[&worker] = node_colour::NOT_VISITED;
+    // BFS od ramp; odbiorcy w kolejności odkrycia, nieosiągalni na końcu w dotychczasowym porządku.
+    std::vector<Worker*> worker_order;
+    std::vector<Storehouse*> storehouse_order;
+    std::unordered_set<const IPackageReceiver*> visited;
+    std::vector<PackageSender*> queue;
+    for (auto& ramp : ramp_) {
+        queue.push_back(&ramp);
+    }
+    auto visit = [&](PackageSender* sender) {
+        for (const auto& preference : sender->receiver_preferences_.get_weights()) {
+            if (!visited.insert(preference.first).second) {
+                continue;
+            }
+            if (auto worker = workers.find(preference.first); worker != workers.end()) {
+                worker_order.push_back(worker->second);
+                queue.push_back(worker->second);
+            } else if (auto storehouse = storehouses.find(preference.first); storehouse != storehouses.end()) {
+                storehouse_order.push_back(storehouse->second);
+            }
+        }
+    };
+    for (std::size_t i = 0; i < queue.size(); ++i) {
+        visit(queue[i]);
+    }
+    for (auto& worker : worker_) {
+        if (!visited.count(&worker)) {
+            worker_order.push_back(&worker);
+        }
     }
-    try {
-        for (const PackageSender &ramp: ramp_) {
-            is_storehouse_achievable(&ramp, map);
+    for (auto& storehouse : storehouse_) {
+        if (!visited.count(&storehouse)) {
+            storehouse_order.push_back(&storehouse);
         }
     }
-    catch (...) {
-        return false;
+
+    SimulationContext::Scope scope(*context_);
+    std::unordered_map<const IPackageReceiver*, IPackageReceiver*> relocation;
+    NodeCollection<Worker> reordered_workers;
+    reordered_workers.reserve(worker_order.size());
+    for (auto worker : worker_order) {
+        relocation.emplace(worker, &reordered_workers.add(std::move(*worker)));
+    }
+    NodeCollection<Storehouse> reordered_storehouses;
+    reordered_storehouses.reserve(storehouse_order.size());
+    for (auto storehouse : storehouse_order) {
+        relocation.emplace(storehouse, &reordered_storehouses.add(std::move(*storehouse)));
+    }
+    worker_ = std::move(reordered_workers);
+    storehouse_ = std::move(reordered_storehouses);
+
+    // Indeks odwrotny i osiągalność budowane od nowa dla nowych adresów.
+    senders_->clear();
+    reachability_->clear();
+    reachability_->disable();
+    for (auto& storehouse : storehouse_) {
+        reachability_->add_storehouse(storehouse);
     }
-    return true;
+    for (auto& ramp : ramp_) {
+        ramp.receiver_preferences_.relocate(relocation);
+        reachability_->add_sender(ramp, nullptr, true);
+    }
+    for (auto& worker : worker_) {
+        worker.receiver_preferences_.relocate(relocation);
+        reachability_->add_sender(worker, &worker, false);
+    }
+    for (auto& ramp : ramp_) {
+        attach_sender(ramp);
+    }
+    for (auto& worker : worker_) {
+        attach_sender(worker);
+    }
+    reachability_->rebuild();
+}
+
+ExecutionGraph Factory::compile() {
+    ExecutionGraph graph(*context_);
+    std::unordered_map<const IPackageReceiver*, ReceiverHandle> receiver_handle;
+
+    // Typ kolejki i zapasu rozpoznawany raz, tutaj -- nie przy każdym półprodukcie.
+    for (auto& worker : worker_) {
+        auto kind = ReceiverHandle::Kind::OTHER_WORKER;
+        auto ring = dynamic_cast<const PackageQueue*>(worker.get_queue());
+        if (ring && ring->get_queue_type() == PackageQueueType::FIFO) {
+            kind = ReceiverHandle::Kind::RING_WORKER;
+            graph.fifo_workers_.push_back(&worker);
+        } else if (ring) {
+            kind = ReceiverHandle::Kind::RING_WORKER;
+            graph.lifo_workers_.push_back(&worker);
+        } else if (dynamic_cast<const PriorityPackageQueue*>(worker.get_queue())) {
+            kind = ReceiverHandle::Kind::PRIORITY_WORKER;
+            graph.priority_workers_.push_back(&worker);
+        } else {
+            graph.other_workers_.push_back(&worker);
+        }
+        receiver_handle.emplace(&worker, ReceiverHandle(kind, graph.workers_.size()));
+        graph.workers_.push_back(&worker);
+    }
+    for (auto& storehouse : storehouse_) {
+        auto kind = ReceiverHandle::Kind::OTHER_STOREHOUSE;
+        if (dynamic_cast<const PackageQueue*>(&storehouse.get_stockpile())) {
+            kind = ReceiverHandle::Kind::RING_STOREHOUSE;
+        } else if (dynamic_cast<const BitmapStockpile*>(&storehouse.get_stockpile())) {
+            kind = ReceiverHandle::Kind::BITMAP_STOREHOUSE;
+        }
+        receiver_handle.emplace(&storehouse, ReceiverHandle(kind, graph.storehouses_.size()));
+        graph.storehouses_.push_back(&storehouse);
+    }
+    if (std::max(graph.workers_.size(), graph.storehouses_.size()) >= (std::size_t(1) << ReceiverHandle::index_bits)) {
+        throw std::length_error("Too many receivers for the execution graph");
+    }
+    for (auto& ramp : ramp_) {
+        graph.ramps_.push_back(&ramp);
+        graph.senders_.push_back(&ramp);
+    }
+    for (auto worker : graph.workers_) {
+        graph.senders_.push_back(worker);
+    }
+
+    graph.offsets_.reserve(graph.senders_.size() + 1);
+    graph.offsets_.push_back(0);
+    std::vector<double> weights;
+    std::vector<AliasColumn> columns;
+    for (auto sender : graph.senders_) {
+        weights.clear();
+        for (const auto& preference : sender->receiver_preferences_.get_weights()) {
+            auto handle = receiver_handle.find(preference.first);
+            if (handle == receiver_handle.end()) {
+                throw std::logic_error("Receiver does not belong to the factory");
+            }
+            graph.targets_.push_back(handle->second);
+            weights.push_back(preference.second);
+        }
+        build_alias_table(weights, columns);
+        graph.alias_table_.insert(graph.alias_table_.end(), columns.begin(), columns.end());
+        graph.offsets_.push_back(graph.targets_.size());
+    }
+    return graph;
 }
 
 void Factory::do_deliveries(Time time) {
+    SimulationContext::Scope scope(*context_);
+    context_->set_turn(time);
     for(auto e = ramp_.begin(); e != ramp_.end(); e++){
         e->deliver_goods(time);
     }
 }
 
 void Factory::do_work(Time time) {
+    SimulationContext::Scope scope(*context_);
     for(auto e = worker_.begin(); e != worker_.end(); e++){
         e->do_work(time);
     }
 }
 
 void Factory::do_package_passing() {
+    SimulationContext::Scope scope(*context_);
     for(auto e = ramp_.begin(); e != ramp_.end(); e++){
         e->send_package();
     }
@@ -143,6 +485,7 @@ ElementType ElementType_ (std::string line){
 PackageQueueType PackageQueueType_ (std::string line){
     if(line == "FIFO") {return PackageQueueType::FIFO;}
     if(line == "LIFO") {return PackageQueueType::LIFO;}
+    if(line == "PRIORITY") {return PackageQueueType::PRIORITY;}
     throw std::invalid_argument ("Non-existent queue type");
 }
 
@@ -152,10 +495,31 @@ std::string PackageQueueType_string_ (PackageQueueType type){
             return "LIFO";
         case PackageQueueType::FIFO:
             return "FIFO";
+        case PackageQueueType::PRIORITY:
+            return "PRIORITY";
     }
     throw std::invalid_argument("Non-existent queue type");
 }
 
+StockpileType StockpileType_ (std::string line){
+    if(line == "QUEUE") {return StockpileType::QUEUE;}
+    if(line == "BITMAP") {return StockpileType::BITMAP;}
+    if(line == "LOG") {return StockpileType::LOG;}
+    throw std::invalid_argument ("Non-existent stock type");
+}
+
+std::string StockpileType_string_ (StockpileType type){
+    switch (type) {
+        case StockpileType::QUEUE:
+            return "QUEUE";
+        case StockpileType::BITMAP:
+            return "BITMAP";
+        case StockpileType::LOG:
+            return "LOG";
+    }
+    throw std::invalid_argument("Non-existent stock type");
+}
+
 std::string ReceiverType_string_ (ReceiverType type){
     switch(type) {
         case ReceiverType::WORKER:
@@ -193,8 +557,8 @@ ParsedLineData ParseLine_ (std::string line){
     return node;
 }
 
-Factory load_factory_structure(std::istream& is){
-    Factory factory;
+Factory load_factory_structure(std::istream& is, SimulationContext& context){
+    FactoryBuilder builder(context);
 
     std::string line;
     while(std::getline(is, line)){
@@ -203,73 +567,77 @@ Factory load_factory_structure(std::istream& is){
 
             switch (parsed.element_type) {
                 case ElementType::RAMP: {
-                    factory.add_ramp(Ramp(std::stoi(parsed.parameters["id"]), std::stoi(parsed.parameters["delivery-interval"])));
+                    builder.add_ramp({std::stoi(parsed.parameters["id"]), std::stoi(parsed.parameters["delivery-interval"])});
                     break;
                 }
 
                 case ElementType::STOREHOUSE: {
-                    factory.add_storehouse(Storehouse(std::stoi(parsed.parameters["id"])));
+                    StorehouseRecord record{std::stoi(parsed.parameters["id"])};
+                    if (parsed.parameters.count("stock-type")) {
+                        record.stock_type = StockpileType_(parsed.parameters["stock-type"]);
+                    }
+                    builder.add_storehouse(record);
                     break;
                 }
 
                 case ElementType::WORKER: {
-                    if (parsed.parameters["queue-type"] == "FIFO"){
-                        factory.add_worker(Worker(std::stoi(parsed.parameters["id"]), std::stoi(parsed.parameters["processing-time"]), std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
-                    }
-
-                    else if (parsed.parameters["queue-type"]=="LIFO"){
-                        factory.add_worker(Worker(std::stoi(parsed.parameters["id"]), std::stoi(parsed.parameters["processing-time"]), std::make_unique<PackageQueue>(PackageQueueType::LIFO)));
+                    WorkerRecord record{std::stoi(parsed.parameters["id"]), std::stoi(parsed.parameters["processing-time"]),
+                                        PackageQueueType_(parsed.parameters["queue-type"])};
+                    if (parsed.parameters.count("capacity")) {
+                        record.capacity = std::stoul(parsed.parameters["capacity"]);
+                        if (*record.capacity == 0) {
+                            throw std::invalid_argument("Worker capacity must be positive");
+                        }
                     }
+                    builder.add_worker(record);
                     break;
                 }
 
                 case ElementType::LINK: {
-                    std::vector<std::string> src;
-                    std::vector<std::string> dest;
-                    std::string token;
-                    std::istringstream token_src(parsed.parameters["src"]);
-
-                    while (std::getline(token_src, token, '-')){
-                        src.push_back(token);
+                    auto src = SplitLine_(parsed.parameters["src"], '-');
+                    auto dest = SplitLine_(parsed.parameters["dest"], '-');
+
+                    LinkRecord record{};
+                    if (src[0] == "ramp") {
+                        record.src_type = ElementType::RAMP;
+                    } else if (src[0] == "worker") {
+                        record.src_type = ElementType::WORKER;
+                    } else {
+                        throw std::invalid_argument("Non-existent link source type");
                     }
-
-                    std::istringstream token_dest(parsed.parameters["dest"]);
-
-                    while (std::getline(token_dest, token, '-')){
-                        dest.push_back(token);
-                    }
-
-                    if (src[0] == "worker" && dest[0] == "store"){
-                        auto obj_src = factory.find_worker_by_id(std::stol(src[1]));
-                        auto obj_dest = factory.find_storehouse_by_id(std::stol(dest[1]));
-                        obj_src->receiver_preferences_.add_receiver(&*obj_dest);
-                    }
-                    else if (src[0] == "ramp" && dest[0] == "worker"){
-                        auto obj_src = factory.find_ramp_by_id(std::stol(src[1]));
-                        auto obj_dest = factory.find_worker_by_id(std::stol(dest[1]));
-                        obj_src->receiver_preferences_.add_receiver(&*obj_dest);
+                    if (dest[0] == "worker") {
+                        record.dest_type = ReceiverType::WORKER;
+                    } else if (dest[0] == "store") {
+                        record.dest_type = ReceiverType::STOREHOUSE;
+                    } else {
+                        throw std::invalid_argument("Non-existent link destination type");
                     }
-                    else if (src[0] == "worker" && dest[0] == "worker") {
-                        auto obj_src = factory.find_worker_by_id(std::stol(src[1]));
-                        auto obj_dest = factory.find_worker_by_id(std::stol(dest[1]));
-                        obj_src->receiver_preferences_.add_receiver(&*obj_dest);
+                    record.src_id = std::stoi(src[1]);
+                    record.dest_id = std::stoi(dest[1]);
+                    if (parsed.parameters.count("p")) {
+                        record.weight = std::stod(parsed.parameters["p"]);
                     }
-                    else if(src[0] == "ramp" && dest[0] == "store"){
-                        auto obj_src = factory.find_ramp_by_id(std::stol(src[1]));
-                        auto obj_dest = factory.find_storehouse_by_id(std::stol(dest[1]));
-                        obj_src->receiver_preferences_.add_receiver(&*obj_dest);
-                    }
-
+                    builder.add_link(record);
                     break;
                 }
             }
         }
     }
 
-    return factory;
+    return builder.build();
 }
 
 
+namespace {
+    // Najkrótszy zapis, który po wczytaniu odtwarza wagę co do bitu -- "0.3" pozostaje "0.3".
+    void write_weight(std::ostream& os, double weight) {
+        std::array<char, 32> buffer{};
+        auto result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), weight);
+        os << " p=";
+        os.write(buffer.data(), result.ptr - buffer.data());
+    }
+}
+
 void save_factory_structure(Factory& factory, std::ostream& os){
     std::ostringstream tm;
 
@@ -277,8 +645,12 @@ void save_factory_structure(Factory& factory, std::ostream& os){
     os << "; == LOADING RAMPS ==" << std::endl << std::endl;
     for(auto iterator = factory.ramp_cbegin(); iterator != factory.ramp_cend(); ++iterator){
         os << "LOADING_RAMP id=" << iterator->get_id() << " delivery-interval="<< iterator->get_delivery_interval() << std::endl;
-        for (auto elements : iterator->receiver_preferences_.get_preferences()){
-            tm << "LINK src=ramp-" << iterator->get_id() << " dest=" << ReceiverType_string_(elements.first->get_receiver_type()) << "-" << elements.first->get_id() << std::endl;
+        for (auto elements : iterator->receiver_preferences_.get_weights()){
+            tm << "LINK src=ramp-" << iterator->get_id() << " dest=" << ReceiverType_string_(elements.first->get_receiver_type()) << "-" << elements.first->get_id();
+            if (elements.second != 1.0) {
+                write_weight(tm, elements.second);
+            }
+            tm << std::endl;
         }
 
         tm << std::endl;
@@ -287,9 +659,17 @@ void save_factory_structure(Factory& factory, std::ostream& os){
     //--WORKERS--//
     os << "; == WORKERS ==" << std::endl << std::endl;
     for(auto iterator = factory.worker_cbegin(); iterator != factory.worker_cend(); ++iterator){
-        os << "WORKER id=" << iterator->get_id() << " processing-time="<< iterator->get_processing_duration() << " queue-type=" << PackageQueueType_string_(iterator->get_queue()->get_queue_type()) << std::endl;
-        for (auto elements : iterator->receiver_preferences_.get_preferences()){
-            tm << "LINK src=worker-" << iterator->get_id() << " dest=" << ReceiverType_string_(elements.first->get_receiver_type()) << "-" << elements.first->get_id() << std::endl;
+        os << "WORKER id=" << iterator->get_id() << " processing-time="<< iterator->get_processing_duration() << " queue-type=" << PackageQueueType_string_(iterator->get_queue()->get_queue_type());
+        if (iterator->get_capacity()) {
+            os << " capacity=" << *iterator->get_capacity();
+        }
+        os << std::endl;
+        for (auto elements : iterator->receiver_preferences_.get_weights()){
+            tm << "LINK src=worker-" << iterator->get_id() << " dest=" << ReceiverType_string_(elements.first->get_receiver_type()) << "-" << elements.first->get_id();
+            if (elements.second != 1.0) {
+                write_weight(tm, elements.second);
+            }
+            tm << std::endl;
         }
         tm << std::endl;
     }
@@ -297,7 +677,11 @@ void save_factory_structure(Factory& factory, std::ostream& os){
     //--STOREHOUSES--//
     os << "; == STOREHOUSES ==" << std::endl << std::endl;
     for(auto iterator = factory.storehouse_cbegin(); iterator != factory.storehouse_cend(); ++iterator){
-        os << "STOREHOUSE id=" << iterator->get_id() <<std::endl;
+        os << "STOREHOUSE id=" << iterator->get_id();
+        if (iterator->get_stockpile_type()) {
+            os << " stock-type=" << StockpileType_string_(*iterator->get_stockpile_type());
+        }
+        os << std::endl;
     }
 
     //--LINKS--//
@@ -0,0 +1,105 @@
+#include "factory_builder.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+void FactoryBuilder::reserve(std::size_t ramps, std::size_t workers, std::size_t storehouses, std::size_t links) {
+    ramps_.reserve(ramps);
+    workers_.reserve(workers);
+    storehouses_.reserve(storehouses);
+    links_.reserve(links);
+}
+
+Factory FactoryBuilder::build() const {
+    SimulationContext::Scope scope(*context_);
+    Factory factory(*context_);
+    factory.reserve(ramps_.size(), workers_.size(), storehouses_.size());
+    // Osiągalność liczona raz, po dodaniu wszystkich połączeń.
+    factory.reachability_->disable();
+
+    for (const auto& record : ramps_) {
+        factory.add_ramp(Ramp(record.id, record.delivery_interval));
+    }
+    for (const auto& record : workers_) {
+        factory.add_worker(Worker(record.id, record.processing_time, make_package_queue(record.queue_type, *context_), record.capacity));
+    }
+    for (const auto& record : storehouses_) {
+        if (record.stock_type) {
+            factory.add_storehouse(Storehouse(record.id, *record.stock_type, *context_));
+        } else {
+            factory.add_storehouse(Storehouse(record.id, *context_));
+        }
+    }
+
+    // Numeracja nadawców: rampy 0..R-1, robotnicy R..R+W-1 (kolejność kolekcji fabryki).
+    auto ramp_count = ramps_.size();
+    std::vector<PackageSender*> senders;
+    senders.reserve(ramp_count + workers_.size());
+    for (auto& ramp : factory.ramp_) {
+        senders.push_back(&ramp);
+    }
+    for (auto& worker : factory.worker_) {
+        senders.push_back(&worker);
+    }
+
+    auto unknown = [](const char* what, ElementID id) {
+        return std::invalid_argument(std::string("Link refers to a non-existent ") + what + " " + std::to_string(id));
+    };
+
+    // Sortowanie przez zliczanie po nadawcy: O(V + E), bez alokacji na węzeł.
+    std::vector<std::size_t> sender_of(links_.size());
+    std::vector<IPackageReceiver*> receiver_of(links_.size());
+    std::vector<std::size_t> offsets(senders.size() + 1, 0);
+    for (std::size_t i = 0; i < links_.size(); ++i) {
+        const auto& link = links_[i];
+        if (link.src_type == ElementType::RAMP) {
+            auto it = factory.ramp_.find_by_id(link.src_id);
+            if (it == factory.ramp_.end()) {
+                throw unknown("ramp", link.src_id);
+            }
+            sender_of[i] = std::size_t(it - factory.ramp_.begin());
+        } else if (link.src_type == ElementType::WORKER) {
+            auto it = factory.worker_.find_by_id(link.src_id);
+            if (it == factory.worker_.end()) {
+                throw unknown("worker", link.src_id);
+            }
+            sender_of[i] = ramp_count + std::size_t(it - factory.worker_.begin());
+        } else {
+            throw std::invalid_argument("Link source must be a ramp or a worker");
+        }
+
+        if (link.dest_type == ReceiverType::WORKER) {
+            auto it = factory.worker_.find_by_id(link.dest_id);
+            if (it == factory.worker_.end()) {
+                throw unknown("worker", link.dest_id);
+            }
+            receiver_of[i] = &*it;
+        } else {
+            auto it = factory.storehouse_.find_by_id(link.dest_id);
+            if (it == factory.storehouse_.end()) {
+                throw unknown("storehouse", link.dest_id);
+            }
+            receiver_of[i] = &*it;
+        }
+        ++offsets[sender_of[i] + 1];
+    }
+
+    for (std::size_t s = 0; s < senders.size(); ++s) {
+        offsets[s + 1] += offsets[s];
+    }
+    std::vector<std::pair<IPackageReceiver*, double>> grouped(links_.size());
+    auto fill = offsets;
+    for (std::size_t i = 0; i < links_.size(); ++i) {
+        grouped[fill[sender_of[i]]++] = {receiver_of[i], links_[i].weight};
+    }
+
+    for (std::size_t s = 0; s < senders.size(); ++s) {
+        auto first = grouped.begin() + std::ptrdiff_t(offsets[s]);
+        auto last = grouped.begin() + std::ptrdiff_t(offsets[s + 1]);
+        senders[s]->receiver_preferences_.add_receivers(first, last);
+    }
+    factory.reachability_->rebuild();
+
+    return factory;
+}
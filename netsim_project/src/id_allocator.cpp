@@ -0,0 +1,103 @@
+#include "id_allocator.hpp"
+
+#include <stdexcept>
+
+namespace {
+    constexpr std::uint64_t all_free = ~std::uint64_t(0);
+
+    std::size_t lowest_bit(std::uint64_t word) {
+        return static_cast<std::size_t>(__builtin_ctzll(word));
+    }
+}
+
+ElementID IdAllocator::allocate() {
+    if (levels_.empty() || levels_.back().front() == 0) {
+        grow(capacity() * 2);
+    }
+
+    std::size_t bit = 0;
+    for (auto level = levels_.rbegin(); level != levels_.rend(); ++level) {
+        bit = bit * word_bits_ + lowest_bit((*level)[bit]);
+    }
+
+    mark_assigned(bit);
+    return static_cast<ElementID>(bit + 1);
+}
+
+void IdAllocator::reserve(ElementID id) {
+    if (id <= 0) {
+        throw std::invalid_argument("Package ID must be positive");
+    }
+
+    auto bit = static_cast<std::size_t>(id - 1);
+    if (bit >= capacity()) {
+        grow(bit + 1);
+    }
+    if (!is_assigned(id)) {
+        mark_assigned(bit);
+    }
+}
+
+void IdAllocator::release(ElementID id) {
+    if (is_assigned(id)) {
+        mark_free(static_cast<std::size_t>(id - 1));
+    }
+}
+
+bool IdAllocator::is_assigned(ElementID id) const {
+    if (id <= 0 || static_cast<std::size_t>(id - 1) >= capacity()) {
+        return false;
+    }
+    auto bit = static_cast<std::size_t>(id - 1);
+    return (levels_.front()[bit / word_bits_] & (std::uint64_t(1) << (bit % word_bits_))) == 0;
+}
+
+void IdAllocator::grow(std::size_t min_capacity) {
+    std::size_t words = levels_.empty() ? 1 : levels_.front().size();
+    while (words * word_bits_ < min_capacity) {
+        words *= 2;
+    }
+
+    if (levels_.empty()) {
+        levels_.emplace_back();
+    }
+    levels_.resize(1);
+    levels_.front().resize(words, all_free);
+
+    // Poziomy wyższe budowane od nowa -- koszt O(n) amortyzuje się przy podwajaniu.
+    while (levels_.back().size() > 1) {
+        const auto& lower = levels_.back();
+        std::vector<std::uint64_t> upper((lower.size() + word_bits_ - 1) / word_bits_, 0);
+        for (std::size_t i = 0; i < lower.size(); ++i) {
+            if (lower[i] != 0) {
+                upper[i / word_bits_] |= std::uint64_t(1) << (i % word_bits_);
+            }
+        }
+        levels_.push_back(std::move(upper));
+    }
+}
+
+void IdAllocator::mark_assigned(std::size_t bit) {
+    ++assigned_;
+    for (auto& level : levels_) {
+        auto& word = level[bit / word_bits_];
+        word &= ~(std::uint64_t(1) << (bit % word_bits_));
+        if (word != 0) {
+            return;
+        }
+        bit /= word_bits_;
+    }
+}
+
+void IdAllocator::mark_free(std::size_t bit) {
+    --assigned_;
+    for (auto& level : levels_) {
+        auto& word = level[bit / word_bits_];
+        bool was_empty = word == 0;
+        word |= std::uint64_t(1) << (bit % word_bits_);
+        if (!was_empty) {
+            return;
+        }
+        bit /= word_bits_;
+    }
+}
@@ -1,84 +1,127 @@
 #include "nodes.hpp"
 
-void ReceiverPreferences::add_receiver(IPackageReceiver *r) {
-    auto num_of_receivers_begin = double(preferences_t_.size());
-    if (num_of_receivers_begin == 0) {
-        preferences_t_[r] = 1.0;
-    } else {
-        for (auto &rec: preferences_t_) {
-            rec.second = 1 / (num_of_receivers_begin + 1);
-        }
-        preferences_t_[r] = 1 / (num_of_receivers_begin + 1);
+#include <cmath>
+#include <stdexcept>
+
+void ReceiverPreferences::add_receiver(IPackageReceiver *r, double weight) {
+    if (!(weight >= 0) || std::isinf(weight)) {
+        throw std::invalid_argument("Receiver weight must be finite and non-negative");
+    }
+    bool is_new = weights_.insert_or_assign(r, weight).second;
+    invalidate();
+    if (is_new && observer_) {
+        observer_->on_receiver_added(*owner_, r);
     }
 }
 
 void ReceiverPreferences::remove_receiver(IPackageReceiver *r) {
-    auto num_of_receivers_begin = double(preferences_t_.size());
-    if (num_of_receivers_begin > 1) {
-        for (auto &rec: preferences_t_) {
-            if (rec.first != r) {
-                rec.second = 1 / (num_of_receivers_begin - 1);
-            }
+    if (weights_.erase(r)) {
+        invalidate();
+        if (observer_) {
+            observer_->on_receiver_removed(*owner_, r);
         }
     }
-    preferences_t_.erase(r);
+}
+
+void ReceiverPreferences::relocate(const std::unordered_map<const IPackageReceiver*, IPackageReceiver*>& relocation) {
+    preferences_t relocated;
+    for (const auto &rec: weights_) {
+        auto it = relocation.find(rec.first);
+        relocated.emplace(it != relocation.end() ? it->second : rec.first, rec.second);
+    }
+    weights_ = std::move(relocated);
+    invalidate();
+}
+
+void ReceiverPreferences::rebuild_alias_table() {
+    auto n = weights_.size();
+    std::vector<double> weights;
+    weights.reserve(n);
+    for (const auto &rec: weights_) {
+        weights.push_back(rec.second);
+    }
+    std::vector<std::uint32_t> worklist(n);
+    alias_table_ = std::make_unique<AliasColumn[]>(n);
+    build_alias_table(weights.data(), n, alias_table_.get(), worklist.data());
+}
+
+double ReceiverPreferences::draw_probability() {
+    if (stream_ == 0) {
+        return context_->generate_probability();
+    }
+    if (draw_turn_ != context_->turn()) {
+        draw_turn_ = context_->turn();
+        draws_ = 0;
+    }
+    return context_->generate_probability(stream_, draws_++);
 }
 
 IPackageReceiver *ReceiverPreferences::choose_receiver() {
-    auto prob = pg_();
-    if (prob >= 0 && prob <= 1) {
-        double distribution = 0.0;
-        for (auto &rec: preferences_t_) {
-            distribution = distribution + rec.second;
-            if (distribution < 0 || distribution > 1) {
-                return nullptr;
-            }
-            if (prob <= distribution) {
-                return rec.first;
-            }
+    constexpr auto inline_capacity = preferences_t::inline_capacity;
+    auto n = weights_.size();
+    if (n <= 1) {
+        return n == 0 ? nullptr : weights_.begin()->first;
+    }
+    auto probability = draw_probability();
+    if (n <= inline_capacity) {
+        // Kilka kolumn taniej zbudować na stosie niż trzymać w każdym węźle.
+        std::array<double, inline_capacity> weights{};
+        std::array<AliasColumn, inline_capacity> columns{};
+        std::array<std::uint32_t, inline_capacity> worklist{};
+        for (std::size_t i = 0; i < n; ++i) {
+            weights[i] = weights_.begin()[i].second;
         }
-        return nullptr;
+        build_alias_table(weights.data(), n, columns.data(), worklist.data());
+        return weights_.begin()[alias_pick(columns.data(), n, probability)].first;
+    }
+    if (!alias_table_) {
+        rebuild_alias_table();
+    }
+    return weights_.begin()[alias_pick(alias_table_.get(), n, probability)].first;
+}
+
+void PackageSender::release_into_context(std::optional<Package>& bufor) const noexcept {
+    // Bufor, z którego przeniesiono nadawcę, trzyma pusty półprodukt.
+    if (bufor && bufor->get_id() != Package::EMPTY_ID) {
+        context().packages().destroy(bufor->release_handle());
     }
-    return nullptr;
 }
 
 void PackageSender::send_package() {
     IPackageReceiver *receiver;
     if (bufor_) {
         receiver = receiver_preferences_.choose_receiver();
+        if (!receiver || !receiver->can_receive_package()) {
+            return;
+        }
+        context().packages().count_hop(bufor_->get_id());
         receiver->receive_package(std::move(*bufor_));
         bufor_.reset();
     }
 }
 
 void Ramp::deliver_goods(Time t) {
-    if (!bufor_) {
-        push_package(Package());
-        bufor_.emplace(id_);
-        t_ = t;
-    } else {
-        if (t - di_ == t_) {
-            push_package(Package());
-        }
+    // Rampa, która nie zdołała wysłać poprzedniej dostawy, pomija kolejną.
+    if ((t - 1) % di_ == 0 && !get_sending_buffer()) {
+        auto& packages = context().packages();
+        auto package = Package::adopt_handle(packages.create());
+        packages.record_origin(package.get_id(), t, id_);
+        push_package(std::move(package));
     }
 }
 
-void Worker::do_work(Time t) {
-    if (!bufor_ && !q_->empty()) {
-        bufor_.emplace(q_->pop());
-        t_ = t;
-    } else {
-        if (t - t_ + 1 == pd_) {
-            push_package(Package(bufor_.value().get_id()));
-            bufor_.reset();
-            if (!q_->empty()) {
-                bufor_.emplace(q_->pop());
-            }
-        }
+void Worker::bind(SimulationContext& context) {
+    if (bufor_ && &context != &this->context()) {
+        throw std::logic_error("Processed package belongs to another simulation context");
     }
+    q_->bind(context);
+    receiver_preferences_.bind(context);
 }
 
 void Worker::receive_package(Package &&p) {
+    if (!can_receive_package()) {
+        throw std::length_error("Worker queue is full");
+    }
     q_->push(std::move(p));
 }
 
@@ -1,35 +1,16 @@
 #include "package.hpp"
+#include "simulation_context.hpp"
 
-std::set<ElementID> Package::freed_IDs;
-std::set<ElementID> Package::assigned_IDs;
+#include <cassert>
 
-Package::~Package() {
-    assigned_IDs.erase(ID_);
-    freed_IDs.insert(ID_);
-}
-Package::Package() {
-    if(freed_IDs.empty()){
-        if(!assigned_IDs.empty()){
-            ID_ = *(assigned_IDs.rbegin()) + 1;
-            assigned_IDs.insert(ID_);
-        } else {
-            ID_ = 1;
-            assigned_IDs.insert(ID_);
-        }
-    } else {
-        ID_ = *(freed_IDs.begin());
-        freed_IDs.erase(ID_);
-        assigned_IDs.insert(ID_);
-    }
-}
+Package::Package() : ID_(SimulationContext::current().packages().create()) {}
 
-Package &Package::operator=(Package &&package) noexcept {
-    if (this == &package)
-        return *this;
-    assigned_IDs.erase(this->ID_);
-    freed_IDs.insert(this->ID_);
-    this->ID_ = package.ID_;
-    assigned_IDs.insert(this->ID_);
-    return *this;
+Package::Package(ElementID ID) : ID_(ID) {
+    SimulationContext::current().packages().reserve(ID_);
 }
 
+void Package::release() noexcept {
+    // Półprodukt zwalniany poza kontekstem, z którego pochodzi, zwolniłby cudze ID.
+    assert(SimulationContext::current().packages().contains(ID_));
+    SimulationContext::current().packages().destroy(ID_);
+}
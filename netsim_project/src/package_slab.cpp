@@ -0,0 +1,64 @@
+#include "package_slab.hpp"
+
+ElementID PackageSlab::create() {
+    auto id = ids_.allocate();
+    reset_slot(id);
+    return id;
+}
+
+void PackageSlab::reserve(ElementID id) {
+    if (!ids_.is_assigned(id)) {
+        ids_.reserve(id);
+        reset_slot(id);
+    }
+}
+
+void PackageSlab::reset_slot(ElementID id) {
+    reset(creation_turn_, id);
+    reset(source_ramp_, id);
+    reset(hop_count_, id);
+}
+
+void PackageSlab::enable(PackageAttribute attribute) {
+    switch (attribute) {
+        case PackageAttribute::CREATION_TURN:
+            creation_turn_.enabled = true;
+            creation_turn_.values.resize(ids_.capacity());
+            break;
+        case PackageAttribute::SOURCE_RAMP:
+            source_ramp_.enabled = true;
+            source_ramp_.values.resize(ids_.capacity());
+            break;
+        case PackageAttribute::HOP_COUNT:
+            hop_count_.enabled = true;
+            hop_count_.values.resize(ids_.capacity());
+            break;
+    }
+}
+
+bool PackageSlab::is_enabled(PackageAttribute attribute) const {
+    switch (attribute) {
+        case PackageAttribute::CREATION_TURN:
+            return creation_turn_.enabled;
+        case PackageAttribute::SOURCE_RAMP:
+            return source_ramp_.enabled;
+        case PackageAttribute::HOP_COUNT:
+            return hop_count_.enabled;
+    }
+    return false;
+}
+
+void PackageSlab::record_origin(ElementID id, Time t, ElementID ramp_id) {
+    if (creation_turn_.enabled) {
+        creation_turn_.values[static_cast<std::size_t>(id - 1)] = t;
+    }
+    if (source_ramp_.enabled) {
+        source_ramp_.values[static_cast<std::size_t>(id - 1)] = ramp_id;
+    }
+}
+
+void PackageSlab::count_hop(ElementID id) {
+    if (hop_count_.enabled) {
+        ++hop_count_.values[static_cast<std::size_t>(id - 1)];
+    }
+}
@@ -42,13 +42,13 @@ void generate_structure_report(const Factory& f, std::ostream& os){
     auto os_WORKER = [&os](const Worker& worker_){
         os << std::endl << "WORKER #" << worker_.get_id() << std::endl;
         os << "  Processing time: " << worker_.get_processing_duration() << std::endl;
-        os  << "  Queue type: " << (worker_.get_queue()->get_queue_type() == PackageQueueType::LIFO ? "LIFO" : "FIFO");
+        os  << "  Queue type: " << PackageQueueType_string_(worker_.get_queue()->get_queue_type());
         os << std::endl << "  Receivers:";
 
         std::vector<ElementID> worker_receiverIDs;
         std::vector<ElementID> storehouse_receiverIDs;
 
-        for (const auto& receiver : worker_.receiver_preferences_.get_preferences()) {
+        for (const auto& receiver : worker_.receiver_preferences_.get_weights()) {
             const auto& receiver_id = receiver.first->get_id();
             if (receiver.first->get_receiver_type() == ReceiverType::WORKER) {
                 worker_receiverIDs.emplace_back(receiver_id);
@@ -108,13 +108,9 @@ void generate_simulation_turn_report(const Factory& f, std::ostream& os, Time t)
 
         //----PBuffer----//
         if (worker_.get_processing_buffer()) {
-            if (t - worker_.get_package_processing_start_time() == 0) {
-                os << "  PBuffer: (empty)" << std::endl;
-            } else {
-                os << "  PBuffer: #" << worker_.get_processing_buffer()->get_id() << " (pt = "
-                   << (t - worker_.get_package_processing_start_time()) << ")"
-                   << std::endl;
-            }
+            os << "  PBuffer: #" << worker_.get_processing_buffer()->get_id() << " (pt = "
+               << (t - worker_.get_package_processing_start_time() + 1) << ")"
+               << std::endl;
         } else {
             os << "  PBuffer: (empty)" << std::endl;
         }
@@ -125,7 +121,7 @@ void generate_simulation_turn_report(const Factory& f, std::ostream& os, Time t)
         if (!worker_queue->empty()) {
             std::vector<ElementID> queue_ids;
             std::transform(worker_queue->cbegin(), worker_queue->cend(), std::back_inserter(queue_ids),
-                           [](const Package &p) { return p.get_id(); });
+                           [](const PackageView &p) { return p.get_id(); });
             std::sort(queue_ids.begin(), queue_ids.end());
             os << "#" << queue_ids[0];
             if (queue_ids.size() > 1) {
@@ -158,13 +154,17 @@ void generate_simulation_turn_report(const Factory& f, std::ostream& os, Time t)
         os << "STOREHOUSE #" << storehouse_.get_id();
 
         if (storehouse_.cbegin() != storehouse_.cend()){
-            std::vector<ElementID> sorted_elements_IDs;
-            std::for_each(storehouse_.cbegin(), storehouse_.cend(), [&sorted_elements_IDs](const Package& p){sorted_elements_IDs.emplace_back(p.get_id());});
-            std::sort(sorted_elements_IDs.begin(), sorted_elements_IDs.end());
-            os << std::endl << "  Stock: #" << sorted_elements_IDs[0];
+            os << std::endl << "  Stock: ";
+            const char* separator = "#";
+            auto print_id = [&os, &separator](ElementID id){ os << separator << id; separator = ", #"; };
 
-            if(sorted_elements_IDs.size() > 1){
-                std::for_each(sorted_elements_IDs.cbegin(), sorted_elements_IDs.cend(), [&os](const ElementID& id){os<<", #"<<id;});
+            if (storehouse_.get_stockpile().is_sorted()) {
+                std::for_each(storehouse_.cbegin(), storehouse_.cend(), [&print_id](const PackageView& p){ print_id(p.get_id()); });
+            } else {
+                std::vector<ElementID> sorted_elements_IDs;
+                std::for_each(storehouse_.cbegin(), storehouse_.cend(), [&sorted_elements_IDs](const PackageView& p){sorted_elements_IDs.emplace_back(p.get_id());});
+                std::sort(sorted_elements_IDs.begin(), sorted_elements_IDs.end());
+                std::for_each(sorted_elements_IDs.cbegin(), sorted_elements_IDs.cend(), print_id);
             }
 
             os << std::endl << std::endl;
@@ -2,14 +2,25 @@
 #include "types.hpp"
 #include "factory.hpp"
 
+#include <stdexcept>
+#include <string>
+
 void simulate(Factory& f,TimeOffset d, const std::function<void (Factory&, Time)>& rf) {
-    if(!f.is_consistent())
-        throw std::logic_error("Not consistent");
+    SimulationContext::Scope scope(f.get_context());
+    auto report = f.check_consistency();
+    if(!report.ok()) {
+        std::string message = "Not consistent:";
+        for (const auto& offender : report.offenders) {
+            message += (offender.type == ElementType::RAMP ? " ramp-" : " worker-") + std::to_string(offender.id);
+        }
+        throw std::logic_error(message);
+    }
     else
         rf(f, d);
+    auto graph = f.compile();
     for(int i = 1; i <= d; i++){
-        f.do_deliveries(i);
-        f.do_package_passing();
-        f.do_work(i);
+        graph.do_deliveries(i);
+        graph.do_package_passing();
+        graph.do_work(i);
     }
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "simulation_context.hpp"
+
+thread_local SimulationContext* SimulationContext::current_ = nullptr;
+
+SimulationContext::SimulationContext(rng_t::result_type seed) : seed_(seed), rng_(seed) {}
+
+SimulationContext& SimulationContext::current() {
+    if (current_ == nullptr) {
+        static thread_local SimulationContext default_context;
+        return default_context;
+    }
+    return *current_;
+}
+
+SimulationContext::Scope::Scope(SimulationContext& context) : previous_(current_) {
+    current_ = &context;
+}
+
+SimulationContext::Scope::~Scope() {
+    current_ = previous_;
+}
@@ -1,13 +1,417 @@
 #include "storage_types.hpp"
+#include "simulation_context.hpp"
 
-Package PackageQueue::pop(){
-    Package package;
-    if (queue_type_ == PackageQueueType::LIFO) {
-        package = std::move(queue_.back());
-        queue_.pop_back();
-    } else if (queue_type_ == PackageQueueType::FIFO) {
-        package = std::move(queue_.front());
-        queue_.pop_front();
-    }
-    return package;
-}
\ No newline at end of file
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+IPackageStockpile::IPackageStockpile() : context_(&SimulationContext::current()) {}
+
+void IPackageStockpile::bind(SimulationContext& context) {
+    if (&context == context_) {
+        return;
+    }
+    if (!empty()) {
+        throw std::logic_error("Stored packages belong to another simulation context");
+    }
+    context_ = &context;
+}
+
+void IPackageStockpile::release_stored(ElementID id) const noexcept {
+    context_->packages().destroy(id);
+}
+
+PackageQueue::PackageQueue(PackageQueueType queue_type) : PackageQueue(queue_type, SimulationContext::current()) {}
+
+PackageQueue::PackageQueue(PackageQueueType queue_type, SimulationContext& context)
+    : IPackageQueue(context), queue_(), queue_type_(queue_type) {
+    if (queue_type_ == PackageQueueType::PRIORITY) {
+        throw std::invalid_argument("PackageQueue supports FIFO and LIFO only");
+    }
+}
+
+std::size_t PackageQueue::read(std::size_t position, PackageView* out, std::size_t count) const {
+    std::size_t n = 0;
+    for (; n < count && position + n < size_; ++n) {
+        out[n] = PackageView(queue_[(head_ + position + n) & mask()]);
+    }
+    return n;
+}
+
+PackageQueue::~PackageQueue() {
+    for (std::size_t i = 0; i < size_; ++i) {
+        release_stored(queue_[(head_ + i) & mask()]);
+    }
+}
+
+void PackageQueue::grow() {
+    std::vector<ElementID> grown(queue_.empty() ? 16 : queue_.size() * 2);
+    for (std::size_t i = 0; i < size_; ++i) {
+        grown[i] = queue_[(head_ + i) & mask()];
+    }
+    queue_.swap(grown);
+    head_ = 0;
+}
+
+PriorityPackageQueue::PriorityPackageQueue(PackageAttribute key)
+    : PriorityPackageQueue(key, SimulationContext::current()) {}
+
+PriorityPackageQueue::PriorityPackageQueue(PackageAttribute key, SimulationContext& context)
+    : IPackageQueue(context), key_(key) {
+    context.packages().enable(key_);
+}
+
+void PriorityPackageQueue::bind(SimulationContext& context) {
+    IPackageQueue::bind(context);
+    context.packages().enable(key_);
+}
+
+std::int64_t PriorityPackageQueue::key_of(ElementID id) const {
+    const auto& packages = context().packages();
+    switch (key_) {
+        case PackageAttribute::CREATION_TURN:
+            return packages.get_creation_turn(id).value_or(0);
+        case PackageAttribute::SOURCE_RAMP:
+            return packages.get_source_ramp(id).value_or(0);
+        case PackageAttribute::HOP_COUNT:
+            return packages.get_hop_count(id).value_or(0);
+    }
+    return 0;
+}
+
+void PriorityPackageQueue::push(Package&& package) {
+    Entry entry{key_of(package.get_id()), package.release_handle()};
+
+    std::size_t i = heap_.size();
+    heap_.push_back(entry);
+    while (i > 0) {
+        std::size_t parent = (i - 1) / arity;
+        if (!(entry < heap_[parent])) {
+            break;
+        }
+        heap_[i] = heap_[parent];
+        i = parent;
+    }
+    heap_[i] = entry;
+}
+
+Package PriorityPackageQueue::pop() {
+    ElementID ID = heap_.front().id;
+    Entry last = heap_.back();
+    heap_.pop_back();
+
+    std::size_t n = heap_.size();
+    std::size_t i = 0;
+    while (n > 0) {
+        std::size_t first_child = i * arity + 1;
+        if (first_child >= n) {
+            break;
+        }
+        std::size_t best = first_child;
+        std::size_t last_child = std::min(first_child + arity, n);
+        for (std::size_t c = first_child + 1; c < last_child; ++c) {
+            if (heap_[c] < heap_[best]) {
+                best = c;
+            }
+        }
+        if (!(heap_[best] < last)) {
+            break;
+        }
+        heap_[i] = heap_[best];
+        i = best;
+    }
+    if (n > 0) {
+        heap_[i] = last;
+    }
+    return Package::adopt_handle(ID);
+}
+
+std::size_t PriorityPackageQueue::read(std::size_t position, PackageView* out, std::size_t count) const {
+    std::size_t n = 0;
+    for (; n < count && position + n < heap_.size(); ++n) {
+        out[n] = PackageView(heap_[position + n].id);
+    }
+    return n;
+}
+
+std::vector<PackageView> PriorityPackageQueue::in_pop_order() const {
+    std::vector<Entry> entries(heap_);
+    std::sort(entries.begin(), entries.end());
+    std::vector<PackageView> views;
+    views.reserve(entries.size());
+    for (const auto& entry : entries) {
+        views.emplace_back(entry.id);
+    }
+    return views;
+}
+
+PriorityPackageQueue::~PriorityPackageQueue() {
+    for (const auto& entry : heap_) {
+        release_stored(entry.id);
+    }
+}
+
+bool BitmapStockpile::Container::contains(std::uint16_t low) const {
+    if (!bitmap.empty()) {
+        return bitmap[low / 64] & (std::uint64_t(1) << (low % 64));
+    }
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+bool BitmapStockpile::Container::insert(std::uint16_t low) {
+    if (!bitmap.empty()) {
+        std::uint64_t mask = std::uint64_t(1) << (low % 64);
+        if (bitmap[low / 64] & mask) {
+            return false;
+        }
+        bitmap[low / 64] |= mask;
+        ++cardinality;
+        return true;
+    }
+
+    if (array.empty() || array.back() < low) {
+        array.push_back(low);
+    } else {
+        auto it = std::lower_bound(array.begin(), array.end(), low);
+        if (*it == low) {
+            return false;
+        }
+        array.insert(it, low);
+    }
+    ++cardinality;
+
+    if (array.size() > array_limit) {
+        bitmap.assign(bitmap_words, 0);
+        for (auto value : array) {
+            bitmap[value / 64] |= std::uint64_t(1) << (value % 64);
+        }
+        std::vector<std::uint16_t>().swap(array);
+    }
+    return true;
+}
+
+std::size_t BitmapStockpile::Container::read(std::size_t rank, ElementID base, PackageView* out, std::size_t count) const {
+    std::size_t n = 0;
+    if (bitmap.empty()) {
+        for (; n < count && rank + n < array.size(); ++n) {
+            out[n] = PackageView(base + array[rank + n]);
+        }
+        return n;
+    }
+
+    std::size_t word = 0;
+    for (auto bits = std::size_t(__builtin_popcountll(bitmap[word])); rank >= bits; bits = std::size_t(__builtin_popcountll(bitmap[word]))) {
+        rank -= bits;
+        ++word;
+    }
+    std::uint64_t bits = bitmap[word];
+    for (; rank > 0; --rank) {
+        bits &= bits - 1;
+    }
+    while (n < count) {
+        while (bits == 0) {
+            if (++word == bitmap_words) {
+                return n;
+            }
+            bits = bitmap[word];
+        }
+        out[n++] = PackageView(base + ElementID(word * 64) + __builtin_ctzll(bits));
+        bits &= bits - 1;
+    }
+    return n;
+}
+
+void BitmapStockpile::push(Package&& package) {
+    auto ID = std::uint32_t(package.get_id());
+    std::size_t high = ID >> 16;
+    if (high < containers_.size() && containers_[high].contains(std::uint16_t(ID & 0xFFFF))) {
+        throw std::logic_error("Package ID already in the stockpile");
+    }
+    if (high >= containers_.size()) {
+        containers_.resize(high + 1);
+    }
+    containers_[high].insert(std::uint16_t(ID & 0xFFFF));
+    package.release_handle();
+    ++size_;
+}
+
+std::size_t BitmapStockpile::read(std::size_t position, PackageView* out, std::size_t count) const {
+    ReadCursor cursor;
+    return read(position, out, count, cursor);
+}
+
+std::size_t BitmapStockpile::read(std::size_t position, PackageView* out, std::size_t count, ReadCursor& cursor) const {
+    if (position < cursor.segment_begin || cursor.segment > containers_.size()) {
+        cursor = ReadCursor();
+    }
+    while (cursor.segment < containers_.size() && position >= cursor.segment_begin + containers_[cursor.segment].cardinality) {
+        cursor.segment_begin += containers_[cursor.segment].cardinality;
+        ++cursor.segment;
+    }
+
+    std::size_t n = 0;
+    std::size_t rank = position - cursor.segment_begin;
+    for (std::size_t c = cursor.segment; c < containers_.size() && n < count; ++c) {
+        n += containers_[c].read(rank, ElementID(c << 16), out + n, count - n);
+        rank = 0;
+    }
+    return n;
+}
+
+std::size_t BitmapStockpile::bytes_used() const {
+    std::size_t bytes = containers_.capacity() * sizeof(Container);
+    for (const auto& container : containers_) {
+        bytes += container.array.capacity() * sizeof(std::uint16_t) + container.bitmap.capacity() * sizeof(std::uint64_t);
+    }
+    return bytes;
+}
+
+BitmapStockpile::~BitmapStockpile() {
+    PackageView chunk[64];
+    ReadCursor cursor;
+    for (std::size_t position = 0; position < size_; ) {
+        std::size_t n = read(position, chunk, 64, cursor);
+        for (std::size_t i = 0; i < n; ++i) {
+            release_stored(chunk[i].get_id());
+        }
+        position += n;
+    }
+}
+
+LogStockpile::LogStockpile(const std::string& directory, std::size_t tail_capacity)
+    : LogStockpile(directory, tail_capacity, SimulationContext::current()) {}
+
+LogStockpile::LogStockpile(const std::string& directory, std::size_t tail_capacity, SimulationContext& context)
+    : IPackageStockpile(context), tail_capacity_(tail_capacity) {
+    std::string path_template = directory + "/netsim-stock-XXXXXX";
+    std::vector<char> path(path_template.begin(), path_template.end());
+    path.push_back('\0');
+
+    fd_ = mkstemp(path.data());
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot create stock log in " + directory + ": " + std::strerror(errno));
+    }
+    path_ = path.data();
+    tail_.reserve(tail_capacity_);
+}
+
+void LogStockpile::push(Package&& package) {
+    tail_.push_back(package.release_handle());
+    if (tail_.size() >= tail_capacity_) {
+        spill();
+    }
+}
+
+void LogStockpile::spill() {
+    const char* data = reinterpret_cast<const char*>(tail_.data());
+    std::size_t bytes = tail_.size() * sizeof(ElementID);
+    while (bytes > 0) {
+        auto written = ::write(fd_, data, bytes);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Cannot write stock log " + path_ + ": " + std::strerror(errno));
+        }
+        data += written;
+        bytes -= std::size_t(written);
+    }
+    spilled_ += tail_.size();
+    tail_.clear();
+}
+
+std::size_t LogStockpile::read(std::size_t position, PackageView* out, std::size_t count) const {
+    std::size_t n = 0;
+    if (position < spilled_) {
+        if (mapped_size_ < spilled_) {
+            unmap();
+            void* mapped = ::mmap(nullptr, spilled_ * sizeof(ElementID), PROT_READ, MAP_SHARED, fd_, 0);
+            if (mapped == MAP_FAILED) {
+                throw std::runtime_error("Cannot map stock log " + path_ + ": " + std::strerror(errno));
+            }
+            mapped_ = static_cast<const ElementID*>(mapped);
+            mapped_size_ = spilled_;
+        }
+        for (; n < count && position + n < spilled_; ++n) {
+            out[n] = PackageView(mapped_[position + n]);
+        }
+    }
+    for (; n < count && position + n < size(); ++n) {
+        out[n] = PackageView(tail_[position + n - spilled_]);
+    }
+    return n;
+}
+
+void LogStockpile::unmap() const {
+    if (mapped_ != nullptr) {
+        ::munmap(const_cast<ElementID*>(mapped_), mapped_size_ * sizeof(ElementID));
+        mapped_ = nullptr;
+        mapped_size_ = 0;
+    }
+}
+
+LogStockpile::~LogStockpile() {
+    // Destruktor nie może rzucać: ID z pliku czytane przez pread, bez mapowania; przy błędzie
+    // odczytu pozostałe ID z pliku przepadają.
+    for (auto id : tail_) {
+        release_stored(id);
+    }
+    unmap();
+    ElementID chunk[1024];
+    std::size_t offset = 0;
+    std::size_t remaining = spilled_ * sizeof(ElementID);
+    while (remaining > 0) {
+        auto bytes = ::pread(fd_, chunk, std::min(remaining, sizeof(chunk)), off_t(offset));
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        std::size_t count = bytes > 0 ? std::size_t(bytes) / sizeof(ElementID) : 0;
+        if (count == 0) {
+            break;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            release_stored(chunk[i]);
+        }
+        offset += count * sizeof(ElementID);
+        remaining -= count * sizeof(ElementID);
+    }
+    ::close(fd_);
+    ::unlink(path_.c_str());
+}
+
+std::unique_ptr<IPackageStockpile> make_stockpile(StockpileType type, const StockpileOptions& options) {
+    return make_stockpile(type, options, SimulationContext::current());
+}
+
+std::unique_ptr<IPackageStockpile> make_stockpile(StockpileType type, const StockpileOptions& options,
+                                                  SimulationContext& context) {
+    switch (type) {
+        case StockpileType::QUEUE:
+            return std::make_unique<PackageQueue>(PackageQueueType::FIFO, context);
+        case StockpileType::BITMAP:
+            return std::make_unique<BitmapStockpile>(context);
+        case StockpileType::LOG:
+            return std::make_unique<LogStockpile>(
+                    options.spill_directory.empty() ? std::filesystem::temp_directory_path().string()
+                                                    : options.spill_directory,
+                    options.tail_capacity, context);
+    }
+    throw std::invalid_argument("Non-existent stockpile type");
+}
+
+std::unique_ptr<IPackageQueue> make_package_queue(PackageQueueType queue_type) {
+    return make_package_queue(queue_type, SimulationContext::current());
+}
+
+std::unique_ptr<IPackageQueue> make_package_queue(PackageQueueType queue_type, SimulationContext& context) {
+    if (queue_type == PackageQueueType::PRIORITY) {
+        return std::make_unique<PriorityPackageQueue>(PackageAttribute::CREATION_TURN, context);
+    }
+    return std::make_unique<PackageQueue>(queue_type, context);
+}
@@ -0,0 +1,313 @@
+#include "topology.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+//--SENDER INDEX--//
+void SenderIndex::on_receiver_added(PackageSender& sender, IPackageReceiver* receiver) {
+    auto& senders = senders_[receiver];
+    positions_[Edge{&sender, receiver}] = senders.size();
+    senders.push_back(&sender);
+    if (next_) {
+        next_->on_receiver_added(sender, receiver);
+    }
+}
+
+void SenderIndex::on_receiver_removed(PackageSender& sender, IPackageReceiver* receiver) {
+    auto edge = positions_.find(Edge{&sender, receiver});
+    if (edge != positions_.end()) {
+        auto it = senders_.find(receiver);
+        auto& senders = it->second;
+        auto position = edge->second;
+        positions_.erase(edge);
+        if (position + 1 != senders.size()) {
+            senders[position] = senders.back();
+            positions_[Edge{senders[position], receiver}] = position;
+        }
+        senders.pop_back();
+        if (senders.empty()) {
+            senders_.erase(it);
+        }
+    }
+    if (next_) {
+        next_->on_receiver_removed(sender, receiver);
+    }
+}
+
+const std::vector<PackageSender*>& SenderIndex::get_senders(const IPackageReceiver* receiver) const {
+    static const std::vector<PackageSender*> none;
+    auto it = senders_.find(receiver);
+    return it != senders_.end() ? it->second : none;
+}
+
+std::vector<PackageSender*> SenderIndex::take_senders(const IPackageReceiver* receiver) {
+    std::vector<PackageSender*> senders;
+    auto it = senders_.find(receiver);
+    if (it != senders_.end()) {
+        senders = std::move(it->second);
+        senders_.erase(it);
+        for (auto sender : senders) {
+            positions_.erase(Edge{sender, receiver});
+        }
+    }
+    return senders;
+}
+
+//--REACHABILITY--//
+ReachabilityTracker::NodeState* ReachabilityTracker::find_state(const PackageSender* sender) {
+    auto it = nodes_.find(sender);
+    return it != nodes_.end() ? &it->second : nullptr;
+}
+
+ReachabilityTracker::NodeState* ReachabilityTracker::find_worker_state(const IPackageReceiver* receiver) {
+    auto it = workers_.find(receiver);
+    return it != workers_.end() ? it->second : nullptr;
+}
+
+ReachabilityTracker::distance_t& ReachabilityTracker::distance(NodeState& node, Direction direction) {
+    return direction == Direction::TO_STOREHOUSE ? node.to_storehouse : node.from_ramp;
+}
+
+ReachabilityTracker::distance_t ReachabilityTracker::base_distance(const NodeState& node, Direction direction) const {
+    if (direction == Direction::TO_STOREHOUSE) {
+        return node.storehouse_links > 0 ? 1 : unreachable_;
+    }
+    return node.is_ramp ? 0 : unreachable_;
+}
+
+void ReachabilityTracker::set_distance(NodeState& node, Direction direction, distance_t value) {
+    distance(node, direction) = value;
+    bool offender = node.from_ramp != unreachable_ && node.to_storehouse == unreachable_;
+    if (offender != node.offender) {
+        node.offender = offender;
+        offender ? ++offenders_ : --offenders_;
+    }
+}
+
+template <typename F>
+void ReachabilityTracker::for_each_support(NodeState& node, Direction direction, F f) {
+    if (direction == Direction::TO_STOREHOUSE) {
+        for (const auto& preference : node.sender->receiver_preferences_.get_weights()) {
+            auto successor = find_worker_state(preference.first);
+            if (successor && successor != &node) {
+                f(*successor);
+            }
+        }
+    } else if (node.as_receiver) {
+        for (auto sender : senders_->get_senders(node.as_receiver)) {
+            auto predecessor = find_state(sender);
+            if (predecessor && predecessor != &node) {
+                f(*predecessor);
+            }
+        }
+    }
+}
+
+template <typename F>
+void ReachabilityTracker::for_each_dependent(NodeState& node, Direction direction, F f) {
+    for_each_support(node, direction == Direction::TO_STOREHOUSE ? Direction::FROM_RAMP : Direction::TO_STOREHOUSE, f);
+}
+
+bool ReachabilityTracker::is_supported(NodeState& node, Direction direction, const std::unordered_set<NodeState*>& affected) {
+    auto current = distance(node, direction);
+    if (base_distance(node, direction) == current) {
+        return true;
+    }
+    bool supported = false;
+    for_each_support(node, direction, [&](NodeState& support) {
+        auto d = distance(support, direction);
+        if (!supported && d != unreachable_ && d + 1 == current && !affected.count(&support)) {
+            supported = true;
+        }
+    });
+    return supported;
+}
+
+void ReachabilityTracker::propagate(std::vector<NodeState*> seeds, Direction direction) {
+    using entry_t = std::pair<distance_t, NodeState*>;
+    std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> queue;
+    for (auto seed : seeds) {
+        queue.push({distance(*seed, direction), seed});
+    }
+    while (!queue.empty()) {
+        auto [d, node] = queue.top();
+        queue.pop();
+        if (d != distance(*node, direction)) {
+            continue;
+        }
+        for_each_dependent(*node, direction, [&](NodeState& dependent) {
+            if (d + 1 < distance(dependent, direction)) {
+                set_distance(dependent, direction, d + 1);
+                queue.push({d + 1, &dependent});
+            }
+        });
+    }
+}
+
+void ReachabilityTracker::decrease(NodeState& node, Direction direction) {
+    auto best = base_distance(node, direction);
+    for_each_support(node, direction, [&](NodeState& support) {
+        auto d = distance(support, direction);
+        if (d != unreachable_) {
+            best = std::min(best, d + 1);
+        }
+    });
+    if (best < distance(node, direction)) {
+        set_distance(node, direction, best);
+        propagate({&node}, direction);
+    }
+}
+
+void ReachabilityTracker::increase(NodeState& node, Direction direction) {
+    if (distance(node, direction) == unreachable_ || is_supported(node, direction, {})) {
+        return;
+    }
+
+    // Faza 1: węzły, które straciły wszystkie najkrótsze ścieżki.
+    std::unordered_set<NodeState*> affected = {&node};
+    std::vector<NodeState*> order = {&node};
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        auto d = distance(*order[i], direction);
+        for_each_dependent(*order[i], direction, [&](NodeState& dependent) {
+            if (!affected.count(&dependent) && distance(dependent, direction) == d + 1
+                && !is_supported(dependent, direction, affected)) {
+                affected.insert(&dependent);
+                order.push_back(&dependent);
+            }
+        });
+    }
+
+    // Faza 2: nowe odległości liczone od niedotkniętej części grafu.
+    for (auto affected_node : order) {
+        set_distance(*affected_node, direction, unreachable_);
+    }
+    std::vector<NodeState*> seeds;
+    for (auto affected_node : order) {
+        auto best = base_distance(*affected_node, direction);
+        for_each_support(*affected_node, direction, [&](NodeState& support) {
+            auto d = distance(support, direction);
+            if (d != unreachable_) {
+                best = std::min(best, d + 1);
+            }
+        });
+        if (best != unreachable_) {
+            set_distance(*affected_node, direction, best);
+            seeds.push_back(affected_node);
+        }
+    }
+    propagate(std::move(seeds), direction);
+}
+
+void ReachabilityTracker::add_sender(PackageSender& sender, const IPackageReceiver* as_receiver, bool is_ramp) {
+    auto& node = nodes_.emplace(&sender, NodeState{&sender, as_receiver, is_ramp}).first->second;
+    if (as_receiver) {
+        workers_[as_receiver] = &node;
+    }
+    if (enabled_ && is_ramp) {
+        set_distance(node, Direction::FROM_RAMP, 0);
+    }
+}
+
+void ReachabilityTracker::remove_sender(const PackageSender& sender) {
+    auto it = nodes_.find(&sender);
+    if (it == nodes_.end()) {
+        return;
+    }
+    if (it->second.offender) {
+        --offenders_;
+    }
+    if (it->second.as_receiver) {
+        workers_.erase(it->second.as_receiver);
+    }
+    nodes_.erase(it);
+}
+
+void ReachabilityTracker::add_storehouse(const IPackageReceiver& storehouse) {
+    storehouses_.insert(&storehouse);
+    for (auto sender : senders_->get_senders(&storehouse)) {
+        on_receiver_added(*sender, const_cast<IPackageReceiver*>(&storehouse));
+    }
+}
+
+void ReachabilityTracker::remove_storehouse(const IPackageReceiver& storehouse) {
+    storehouses_.erase(&storehouse);
+}
+
+void ReachabilityTracker::on_receiver_added(PackageSender& sender, IPackageReceiver* receiver) {
+    auto node = find_state(&sender);
+    if (!node) {
+        return;
+    }
+    if (storehouses_.count(receiver)) {
+        ++node->storehouse_links;
+        if (enabled_) {
+            decrease(*node, Direction::TO_STOREHOUSE);
+        }
+    } else if (auto worker = find_worker_state(receiver); worker && worker != node && enabled_) {
+        decrease(*node, Direction::TO_STOREHOUSE);
+        decrease(*worker, Direction::FROM_RAMP);
+    }
+}
+
+void ReachabilityTracker::on_receiver_removed(PackageSender& sender, IPackageReceiver* receiver) {
+    auto node = find_state(&sender);
+    if (!node) {
+        return;
+    }
+    if (storehouses_.count(receiver)) {
+        --node->storehouse_links;
+        if (enabled_) {
+            increase(*node, Direction::TO_STOREHOUSE);
+        }
+    } else if (auto worker = find_worker_state(receiver); worker && worker != node && enabled_) {
+        increase(*node, Direction::TO_STOREHOUSE);
+        increase(*worker, Direction::FROM_RAMP);
+    }
+}
+
+bool ReachabilityTracker::is_reachable(const PackageSender& sender) const {
+    auto it = nodes_.find(&sender);
+    return it != nodes_.end() && it->second.from_ramp != unreachable_;
+}
+
+void ReachabilityTracker::rebuild() {
+    enabled_ = true;
+    offenders_ = 0;
+    std::vector<NodeState*> from_storehouses;
+    std::vector<NodeState*> from_ramps;
+    for (auto& entry : nodes_) {
+        auto& node = entry.second;
+        node.offender = false;
+        node.to_storehouse = unreachable_;
+        node.from_ramp = unreachable_;
+        node.storehouse_links = 0;
+        for (const auto& preference : node.sender->receiver_preferences_.get_weights()) {
+            if (storehouses_.count(preference.first)) {
+                ++node.storehouse_links;
+            }
+        }
+    }
+    for (auto& entry : nodes_) {
+        auto& node = entry.second;
+        if (node.storehouse_links > 0) {
+            set_distance(node, Direction::TO_STOREHOUSE, 1);
+            from_storehouses.push_back(&node);
+        }
+        if (node.is_ramp) {
+            set_distance(node, Direction::FROM_RAMP, 0);
+            from_ramps.push_back(&node);
+        }
+    }
+    propagate(std::move(from_storehouses), Direction::TO_STOREHOUSE);
+    propagate(std::move(from_ramps), Direction::FROM_RAMP);
+}
+
+void ReachabilityTracker::clear() {
+    nodes_.clear();
+    workers_.clear();
+    storehouses_.clear();
+    offenders_ = 0;
+    enabled_ = true;
+}
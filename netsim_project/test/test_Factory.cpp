@@ -2,8 +2,12 @@
 #include "gtest/gtest.h"
 
 #include "factory.hpp"
+#include "factory_builder.hpp"
 #include "nodes.hpp"
 
+#include <random>
+#include <set>
+
 // DEBUG
 #include <iostream>
 
@@ -140,3 +144,348 @@ TEST(FactoryTest, RemoveWorkerTwoRemainingReceivers) {
     ASSERT_NE(it, prefs.end());
     EXPECT_DOUBLE_EQ(it->second, 1.0 / 2.0);
 }
+
+TEST(FactoryTest, RemoveWorkerDetachesFromWorkersAndOwnReceivers) {
+    // R -> W1 -> W2 -> S, W2 -> W2
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_worker(Worker(2, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+
+    Worker& w1 = *(factory.find_worker_by_id(1));
+    Worker& w2 = *(factory.find_worker_by_id(2));
+    Storehouse& s = *(factory.find_storehouse_by_id(1));
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&w1);
+    w1.receiver_preferences_.add_receiver(&w2);
+    w2.receiver_preferences_.add_receiver(&w2);
+    w2.receiver_preferences_.add_receiver(&s);
+    ASSERT_EQ(factory.get_senders(w2).size(), 2U);
+
+    factory.remove_worker(2);
+
+    EXPECT_TRUE(w1.receiver_preferences_.get_preferences().empty());
+    EXPECT_TRUE(factory.get_senders(s).empty());
+    EXPECT_EQ(factory.get_senders(w1).size(), 1U);
+}
+
+TEST(FactoryTest, RemoveStorehouseDetachesSenders) {
+    // W1 -> {S1, S2}, W2 -> S1
+    Factory factory;
+    factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_worker(Worker(2, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+    factory.add_storehouse(Storehouse(2));
+
+    Worker& w1 = *(factory.find_worker_by_id(1));
+    Worker& w2 = *(factory.find_worker_by_id(2));
+    Storehouse& s1 = *(factory.find_storehouse_by_id(1));
+    Storehouse& s2 = *(factory.find_storehouse_by_id(2));
+    w1.receiver_preferences_.add_receiver(&s1);
+    w1.receiver_preferences_.add_receiver(&s2);
+    w2.receiver_preferences_.add_receiver(&s1);
+
+    factory.remove_storehouse(1);
+
+    EXPECT_TRUE(w2.receiver_preferences_.get_preferences().empty());
+    auto prefs = w1.receiver_preferences_.get_preferences();
+    ASSERT_EQ(prefs.size(), 1U);
+    EXPECT_EQ(prefs.begin()->first, &s2);
+    EXPECT_DOUBLE_EQ(prefs.begin()->second, 1.0);
+}
+
+TEST(FactoryTest, RemoveRampClearsReverseIndex) {
+    Factory factory;
+    factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    Worker& w = *(factory.find_worker_by_id(1));
+
+    // Połączenie ustawione przed dodaniem rampy też trafia do indeksu.
+    Ramp ramp(1, 1);
+    ramp.receiver_preferences_.add_receiver(&w);
+    factory.add_ramp(std::move(ramp));
+    ASSERT_EQ(factory.get_senders(w).size(), 1U);
+
+    factory.remove_ramp(1);
+    EXPECT_TRUE(factory.get_senders(w).empty());
+}
+
+TEST(FactoryTest, RemovingSendersOfSharedStorehouseKeepsReverseIndex) {
+    Factory factory;
+    factory.add_storehouse(Storehouse(1));
+    auto& s = *factory.find_storehouse_by_id(1);
+    for (ElementID id = 1; id <= 6; ++id) {
+        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        factory.find_worker_by_id(id)->receiver_preferences_.add_receiver(&s);
+    }
+
+    // Usunięcie ze środka, z końca i z początku listy nadawców magazynu.
+    for (ElementID id : {3, 6, 1}) {
+        factory.remove_worker(id);
+    }
+    std::set<ElementID> senders;
+    for (auto sender : factory.get_senders(s)) {
+        senders.insert(static_cast<Worker*>(sender)->get_id());
+    }
+    EXPECT_EQ(senders, std::set<ElementID>({2, 4, 5}));
+
+    factory.find_worker_by_id(4)->receiver_preferences_.remove_receiver(&s);
+    factory.remove_worker(2);
+    ASSERT_EQ(factory.get_senders(s).size(), 1U);
+    EXPECT_EQ(static_cast<Worker*>(factory.get_senders(s).front())->get_id(), 5);
+}
+
+TEST(NodeCollectionTest, IsIndexKeptAcrossAddRemoveAndMove) {
+    NodeCollection<Storehouse> storehouses;
+    for (ElementID id = 1; id <= 100; ++id) {
+        storehouses.add(Storehouse(id));
+    }
+    storehouses.remove_by_id(50);
+    EXPECT_EQ(storehouses.find_by_id(50), storehouses.end());
+    EXPECT_EQ(storehouses.find_by_id(51)->get_id(), 51);
+    EXPECT_THROW(storehouses.add(Storehouse(1)), std::invalid_argument);
+
+    NodeCollection<Storehouse> moved(std::move(storehouses));
+    EXPECT_EQ(moved.find_by_id(100)->get_id(), 100);
+    EXPECT_EQ(std::distance(moved.cbegin(), moved.cend()), 99);
+
+    moved.add(Storehouse(50));
+    EXPECT_EQ(moved.find_by_id(50)->get_id(), 50);
+    EXPECT_EQ(std::prev(moved.end())->get_id(), 50);
+}
+
+TEST(FactoryTest, ConsistencyReportListsEveryOffender) {
+    // R1 -> W1 <-> W2 (cykl bez magazynu), R2 bez odbiorców, R3 -> W3 -> S, W4 nieosiągalny
+    Factory factory;
+    for (ElementID id = 1; id <= 3; ++id) {
+        factory.add_ramp(Ramp(id, 1));
+    }
+    for (ElementID id = 1; id <= 4; ++id) {
+        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    }
+    factory.add_storehouse(Storehouse(1));
+
+    auto worker = [&factory](ElementID id) { return &*factory.find_worker_by_id(id); };
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(worker(1));
+    worker(1)->receiver_preferences_.add_receiver(worker(2));
+    worker(2)->receiver_preferences_.add_receiver(worker(1));
+    factory.find_ramp_by_id(3)->receiver_preferences_.add_receiver(worker(3));
+    worker(3)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+
+    auto report = factory.check_consistency();
+    EXPECT_FALSE(report.ok());
+    EXPECT_FALSE(factory.is_consistent());
+
+    std::set<std::pair<ElementID, bool>> offenders;
+    for (const auto& offender : report.offenders) {
+        offenders.insert({offender.id, offender.type == ElementType::RAMP});
+        if (offender.type == ElementType::RAMP && offender.id == 2) {
+            EXPECT_EQ(offender.problem, ConsistencyReport::Problem::NO_RECEIVERS);
+        } else {
+            EXPECT_EQ(offender.problem, ConsistencyReport::Problem::NO_PATH_TO_STOREHOUSE);
+        }
+    }
+    std::set<std::pair<ElementID, bool>> expected = {{1, true}, {2, true}, {1, false}, {2, false}};
+    EXPECT_EQ(offenders, expected);
+    EXPECT_EQ(report.unreachable_workers, std::vector<ElementID>{4});
+
+    // Nieosiągalny robotnik sam nie psuje spójności.
+    worker(4)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+    factory.remove_ramp(1);
+    factory.remove_ramp(2);
+    report = factory.check_consistency();
+    EXPECT_TRUE(report.ok());
+    EXPECT_TRUE(factory.is_consistent());
+    EXPECT_EQ(report.unreachable_workers, (std::vector<ElementID>{1, 2, 4}));
+}
+
+TEST(FactoryTest, IsConsistentOnLongWorkerChain) {
+    // R -> W1 -> W2 -> ... -> Wn -> S -- dawniej rekurencja przepełniała stos.
+    const ElementID n = 200000;
+    FactoryBuilder builder;
+    builder.add_ramp({1, 1});
+    builder.add_storehouse({1});
+    builder.add_link({ElementType::RAMP, 1, ReceiverType::WORKER, 1});
+    for (ElementID id = 1; id <= n; ++id) {
+        builder.add_worker({id, 1});
+        if (id < n) {
+            builder.add_link({ElementType::WORKER, id, ReceiverType::WORKER, id + 1});
+        }
+    }
+    builder.add_link({ElementType::WORKER, n, ReceiverType::STOREHOUSE, 1});
+    auto factory = builder.build();
+
+    EXPECT_TRUE(factory.is_consistent());
+
+    factory.remove_storehouse(1);
+    auto report = factory.check_consistency();
+    ASSERT_EQ(report.offenders.size(), std::size_t(n) + 1);
+}
+
+TEST(FactoryTest, IncrementalConsistencyMatchesFullCheck) {
+    // Losowe edycje: po każdej wynik przyrostowy musi zgadzać się z pełnym przejściem grafu.
+    std::mt19937 rng(7);
+    Factory factory;
+    const ElementID nodes = 12;
+    for (ElementID id = 1; id <= nodes; ++id) {
+        factory.add_ramp(Ramp(id, 1));
+        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        factory.add_storehouse(Storehouse(id));
+    }
+
+    auto pick = [&rng](ElementID n) { return std::uniform_int_distribution<ElementID>(1, n)(rng); };
+    for (int step = 0; step < 3000; ++step) {
+        ElementID a = pick(nodes);
+        ElementID b = pick(nodes);
+        auto ramp = factory.find_ramp_by_id(a);
+        auto worker = factory.find_worker_by_id(a);
+        auto target_worker = factory.find_worker_by_id(b);
+        auto target_storehouse = factory.find_storehouse_by_id(b);
+
+        switch (pick(8)) {
+            case 1:
+                if (ramp != factory.ramp_cend() && target_worker != factory.worker_cend()) {
+                    ramp->receiver_preferences_.add_receiver(&*target_worker);
+                }
+                break;
+            case 2:
+            case 3:
+                if (worker != factory.worker_cend() && target_worker != factory.worker_cend()) {
+                    worker->receiver_preferences_.add_receiver(&*target_worker);
+                }
+                break;
+            case 4:
+                if (worker != factory.worker_cend() && target_storehouse != factory.storehouse_cend() && pick(3) == 1) {
+                    worker->receiver_preferences_.add_receiver(&*target_storehouse);
+                }
+                break;
+            case 5:
+                if (worker != factory.worker_cend() && target_worker != factory.worker_cend()) {
+                    worker->receiver_preferences_.remove_receiver(&*target_worker);
+                }
+                break;
+            case 6:
+                if (pick(4) == 1) {
+                    factory.remove_storehouse(b);
+                } else if (target_storehouse == factory.storehouse_cend()) {
+                    factory.add_storehouse(Storehouse(b));
+                }
+                break;
+            case 7:
+                if (pick(4) == 1) {
+                    factory.remove_worker(b);
+                } else if (target_worker == factory.worker_cend()) {
+                    factory.add_worker(Worker(b, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+                }
+                break;
+            case 8:
+                if (pick(4) == 1) {
+                    factory.remove_ramp(a);
+                } else if (ramp == factory.ramp_cend()) {
+                    factory.add_ramp(Ramp(a, 1));
+                }
+                break;
+        }
+        ASSERT_EQ(factory.is_consistent(), factory.check_consistency().ok()) << "step " << step;
+    }
+}
+
+TEST(FactoryTest, IncrementalConsistencyOnLongChainEdits) {
+    const ElementID n = 100000;
+    FactoryBuilder builder;
+    builder.add_ramp({1, 1});
+    builder.add_storehouse({1});
+    builder.add_link({ElementType::RAMP, 1, ReceiverType::WORKER, 1});
+    for (ElementID id = 1; id <= n; ++id) {
+        builder.add_worker({id, 1});
+        if (id < n) {
+            builder.add_link({ElementType::WORKER, id, ReceiverType::WORKER, id + 1});
+        }
+    }
+    builder.add_link({ElementType::WORKER, n, ReceiverType::STOREHOUSE, 1});
+    auto factory = builder.build();
+    ASSERT_TRUE(factory.is_consistent());
+
+    // Skrót z początku łańcucha do magazynu zmienia tylko jeden węzeł.
+    auto& first = *factory.find_worker_by_id(1);
+    first.receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+    EXPECT_TRUE(factory.is_consistent());
+
+    factory.remove_storehouse(1);
+    EXPECT_FALSE(factory.is_consistent());
+
+    factory.add_storehouse(Storehouse(1));
+    factory.find_worker_by_id(n)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+    EXPECT_TRUE(factory.is_consistent());
+}
+
+TEST(FactoryTest, PruneUnreachableRemovesDeadSubgraph) {
+    // R -> W1 -> S1; W2 -> W3 -> S2 (nieosiągalne); W3 -> S1
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    for (ElementID id = 1; id <= 3; ++id) {
+        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    }
+    factory.add_storehouse(Storehouse(1));
+    factory.add_storehouse(Storehouse(2));
+
+    auto worker = [&factory](ElementID id) { return &*factory.find_worker_by_id(id); };
+    auto storehouse = [&factory](ElementID id) { return &*factory.find_storehouse_by_id(id); };
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(worker(1));
+    worker(1)->receiver_preferences_.add_receiver(storehouse(1));
+    worker(2)->receiver_preferences_.add_receiver(worker(3));
+    worker(3)->receiver_preferences_.add_receiver(storehouse(2));
+    worker(3)->receiver_preferences_.add_receiver(storehouse(1));
+
+    auto report = factory.prune_unreachable();
+
+    EXPECT_EQ(report.workers, std::vector<ElementID>({2, 3}));
+    EXPECT_EQ(report.storehouses, std::vector<ElementID>({2}));
+    EXPECT_EQ(std::distance(factory.worker_cbegin(), factory.worker_cend()), 1);
+    EXPECT_EQ(factory.find_storehouse_by_id(2), factory.storehouse_cend());
+    EXPECT_EQ(factory.get_senders(*storehouse(1)).size(), 1U);
+    EXPECT_TRUE(factory.is_consistent());
+    EXPECT_TRUE(factory.check_consistency().ok());
+
+    EXPECT_TRUE(factory.prune_unreachable().empty());
+}
+
+TEST(FactoryTest, ReorderForLocalityFollowsRampBfsAndKeepsLinks) {
+    // R -> W1 -> W2 -> ... -> W5 -> S1; W6 nieosiągalny; robotnicy dodani w odwrotnej kolejności.
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    for (ElementID id = 6; id >= 1; --id) {
+        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    }
+    factory.add_storehouse(Storehouse(2));
+    factory.add_storehouse(Storehouse(1));
+
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(1));
+    for (ElementID id = 1; id < 5; ++id) {
+        factory.find_worker_by_id(id)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(id + 1));
+    }
+    factory.find_worker_by_id(5)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+
+    factory.reorder_for_locality();
+
+    std::vector<ElementID> order;
+    for (auto it = factory.worker_cbegin(); it != factory.worker_cend(); ++it) {
+        order.push_back(it->get_id());
+    }
+    EXPECT_EQ(order, std::vector<ElementID>({1, 2, 3, 4, 5, 6}));
+    EXPECT_EQ(factory.storehouse_cbegin()->get_id(), 1);
+    // Sąsiedzi w łańcuchu leżą obok siebie w pamięci.
+    auto address = [&factory](ElementID id) { return reinterpret_cast<const char*>(&*factory.find_worker_by_id(id)); };
+    EXPECT_GT(address(2), address(1));
+    EXPECT_LT(std::size_t(address(2) - address(1)), 2 * sizeof(Worker));
+
+    const auto& prefs = factory.find_worker_by_id(1)->receiver_preferences_.get_preferences();
+    ASSERT_EQ(prefs.size(), 1U);
+    EXPECT_EQ(prefs.begin()->first, &*factory.find_worker_by_id(2));
+    EXPECT_EQ(factory.get_senders(*factory.find_storehouse_by_id(1)).size(), 1U);
+    EXPECT_TRUE(factory.is_consistent());
+
+    // Kolejne edycje nadal aktualizują indeks i osiągalność.
+    factory.remove_storehouse(1);
+    EXPECT_FALSE(factory.is_consistent());
+    EXPECT_TRUE(factory.find_worker_by_id(5)->receiver_preferences_.get_preferences().empty());
+}
@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+
+#include "factory_builder.hpp"
+
+TEST(FactoryBuilderTest, BuildsNodesAndNormalizesFanOutOnce) {
+    // R -> W1..Wk -> S
+    const ElementID k = 1000;
+    SimulationContext context;
+    FactoryBuilder builder(context);
+    builder.reserve(1, std::size_t(k), 1, 2 * std::size_t(k));
+
+    builder.add_ramp({1, 2});
+    builder.add_storehouse({1});
+    std::vector<WorkerRecord> workers;
+    std::vector<LinkRecord> links;
+    for (ElementID id = 1; id <= k; ++id) {
+        workers.push_back({id, 1, PackageQueueType::LIFO});
+        links.push_back({ElementType::RAMP, 1, ReceiverType::WORKER, id});
+        links.push_back({ElementType::WORKER, id, ReceiverType::STOREHOUSE, 1});
+    }
+    builder.add_workers(workers);
+    builder.add_links(links);
+
+    auto factory = builder.build();
+
+    EXPECT_EQ(&factory.get_context(), &context);
+    const auto& prefs = factory.find_ramp_by_id(1)->receiver_preferences_.get_preferences();
+    ASSERT_EQ(prefs.size(), std::size_t(k));
+    for (const auto& pref : prefs) {
+        EXPECT_DOUBLE_EQ(pref.second, 1.0 / double(k));
+    }
+    EXPECT_EQ(factory.find_worker_by_id(k)->get_queue()->get_queue_type(), PackageQueueType::LIFO);
+    EXPECT_EQ(factory.get_senders(*factory.find_storehouse_by_id(1)).size(), std::size_t(k));
+    EXPECT_TRUE(factory.is_consistent());
+}
+
+TEST(FactoryBuilderTest, IgnoresDuplicateLinks) {
+    FactoryBuilder builder;
+    builder.add_ramp({1, 1});
+    builder.add_storehouse({1});
+    builder.add_storehouse({2});
+    builder.add_link({ElementType::RAMP, 1, ReceiverType::STOREHOUSE, 1});
+    builder.add_link({ElementType::RAMP, 1, ReceiverType::STOREHOUSE, 2});
+    builder.add_link({ElementType::RAMP, 1, ReceiverType::STOREHOUSE, 1});
+
+    auto factory = builder.build();
+
+    const auto& prefs = factory.find_ramp_by_id(1)->receiver_preferences_.get_preferences();
+    ASSERT_EQ(prefs.size(), 2U);
+    EXPECT_DOUBLE_EQ(prefs.begin()->second, 0.5);
+    EXPECT_EQ(factory.get_senders(*factory.find_storehouse_by_id(1)).size(), 1U);
+}
+
+TEST(FactoryBuilderTest, RejectsLinkToMissingNode) {
+    FactoryBuilder builder;
+    builder.add_ramp({1, 1});
+    builder.add_link({ElementType::RAMP, 1, ReceiverType::WORKER, 7});
+
+    EXPECT_THROW(builder.build(), std::invalid_argument);
+}
@@ -2,6 +2,7 @@
 #include "gtest/gtest.h"
 
 #include "factory.hpp"
+#include "factory_builder.hpp"
 
 #include <set>
 
@@ -34,6 +35,49 @@ TEST(FactoryIOTest, ParseWorker) {
     EXPECT_EQ(PackageQueueType::FIFO, w.get_queue()->get_queue_type());
 }
 
+TEST(FactoryIOTest, ParseWorkerWithCapacity) {
+    std::istringstream iss("WORKER id=1 processing-time=2 queue-type=LIFO capacity=5");
+    auto factory = load_factory_structure(iss);
+
+    ASSERT_EQ(std::next(factory.worker_cbegin(), 1), factory.worker_cend());
+    const auto& w = *(factory.worker_cbegin());
+    EXPECT_EQ(PackageQueueType::LIFO, w.get_queue()->get_queue_type());
+    ASSERT_TRUE(w.get_capacity().has_value());
+    EXPECT_EQ(5U, *w.get_capacity());
+}
+
+TEST(FactoryIOTest, ParseWorkerRejectsZeroCapacity) {
+    std::istringstream iss("WORKER id=1 processing-time=2 queue-type=FIFO capacity=0");
+    EXPECT_THROW(load_factory_structure(iss), std::invalid_argument);
+
+    EXPECT_THROW(Worker(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO), 0), std::invalid_argument);
+}
+
+TEST(FactoryIOTest, ParseAndSavePriorityWorker) {
+    std::istringstream iss("WORKER id=1 processing-time=2 queue-type=PRIORITY");
+    auto factory = load_factory_structure(iss);
+
+    ASSERT_EQ(std::next(factory.worker_cbegin(), 1), factory.worker_cend());
+    EXPECT_EQ(PackageQueueType::PRIORITY, factory.worker_cbegin()->get_queue()->get_queue_type());
+    EXPECT_TRUE(factory.get_context().packages().is_enabled(PackageAttribute::CREATION_TURN));
+
+    std::ostringstream oss;
+    save_factory_structure(factory, oss);
+    EXPECT_NE(oss.str().find("WORKER id=1 processing-time=2 queue-type=PRIORITY\n"), std::string::npos);
+}
+
+TEST(FactoryIOTest, SaveWorkerCapacity) {
+    std::istringstream iss("WORKER id=1 processing-time=2 queue-type=FIFO capacity=5\n"
+                           "WORKER id=2 processing-time=2 queue-type=FIFO\n");
+    auto factory = load_factory_structure(iss);
+
+    std::ostringstream oss;
+    save_factory_structure(factory, oss);
+
+    EXPECT_NE(oss.str().find("WORKER id=1 processing-time=2 queue-type=FIFO capacity=5\n"), std::string::npos);
+    EXPECT_NE(oss.str().find("WORKER id=2 processing-time=2 queue-type=FIFO\n"), std::string::npos);
+}
+
 TEST(FactoryIOTest, ParseStorehouse) {
     std::istringstream iss("STOREHOUSE id=1");
     auto factory = load_factory_structure(iss);
@@ -43,6 +87,23 @@ TEST(FactoryIOTest, ParseStorehouse) {
     EXPECT_EQ(1, s.get_id());
 }
 
+TEST(FactoryIOTest, ParseAndSaveStorehouseStockType) {
+    SimulationContext context;
+    context.stockpile_options().spill_directory = ::testing::TempDir();
+    std::istringstream iss("STOREHOUSE id=1 stock-type=LOG\n"
+                           "STOREHOUSE id=2\n");
+    auto factory = load_factory_structure(iss, context);
+
+    const auto& s1 = *factory.find_storehouse_by_id(1);
+    EXPECT_NE(dynamic_cast<const LogStockpile*>(&s1.get_stockpile()), nullptr);
+    EXPECT_NE(dynamic_cast<const PackageQueue*>(&factory.find_storehouse_by_id(2)->get_stockpile()), nullptr);
+
+    std::ostringstream oss;
+    save_factory_structure(factory, oss);
+    EXPECT_NE(oss.str().find("STOREHOUSE id=1 stock-type=LOG\n"), std::string::npos);
+    EXPECT_NE(oss.str().find("STOREHOUSE id=2\n"), std::string::npos);
+}
+
 TEST(FactoryIOTest, ParseLinkOneReceiver) {
     std::ostringstream oss;
     oss << "LOADING_RAMP id=1 delivery-interval=3" << "\n"
@@ -64,26 +125,26 @@ TEST(FactoryIOTest, ParseLinkOneReceiver) {
     EXPECT_DOUBLE_EQ(prefs[key], 1.0);
 }
 
-//TEST(FactoryIOTest, ParseLinkOneReceiverWithDefinedProbability) {
-//    std::ostringstream oss;
-//    oss << "LOADING_RAMP id=1 delivery-interval=3" << "\n"
-//        << "STOREHOUSE id=1" << "\n"
-//        << "LINK src=ramp-1 dest=store-1 p=1.0" << "\n";
-//    std::istringstream iss(oss.str());
-//    auto factory = load_factory_structure(iss);
-//
-//    ASSERT_EQ(std::next(factory.ramp_cbegin(), 1), factory.ramp_cend());
-//    const auto& r = *(factory.ramp_cbegin());
-//
-//    ASSERT_EQ(std::next(factory.storehouse_cbegin(), 1), factory.storehouse_cend());
-//    const auto& s = *(factory.storehouse_cbegin());
-//
-//    auto prefs = r.receiver_preferences_.get_preferences();
-//    ASSERT_EQ(1U, prefs.size());
-//    auto key = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s));
-//    ASSERT_NE(prefs.find(key), prefs.end());
-//    EXPECT_DOUBLE_EQ(prefs[key], 1.0);
-//}
+TEST(FactoryIOTest, ParseLinkOneReceiverWithDefinedProbability) {
+    std::ostringstream oss;
+    oss << "LOADING_RAMP id=1 delivery-interval=3" << "\n"
+        << "STOREHOUSE id=1" << "\n"
+        << "LINK src=ramp-1 dest=store-1 p=1.0" << "\n";
+    std::istringstream iss(oss.str());
+    auto factory = load_factory_structure(iss);
+
+    ASSERT_EQ(std::next(factory.ramp_cbegin(), 1), factory.ramp_cend());
+    const auto& r = *(factory.ramp_cbegin());
+
+    ASSERT_EQ(std::next(factory.storehouse_cbegin(), 1), factory.storehouse_cend());
+    const auto& s = *(factory.storehouse_cbegin());
+
+    auto prefs = r.receiver_preferences_.get_preferences();
+    ASSERT_EQ(1U, prefs.size());
+    auto key = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s));
+    ASSERT_NE(prefs.find(key), prefs.end());
+    EXPECT_DOUBLE_EQ(prefs[key], 1.0);
+}
 
 TEST(FactoryIOTest, ParseLinkMultipleReceivers) {
     std::ostringstream oss;
@@ -112,32 +173,32 @@ TEST(FactoryIOTest, ParseLinkMultipleReceivers) {
     EXPECT_DOUBLE_EQ(prefs[key2], 0.5);
 }
 
-//TEST(FactoryIOTest, ParseLinkMultipleReceiversWithDefinedProbabilities) {
-//    std::ostringstream oss;
-//    oss << "LOADING_RAMP id=1 delivery-interval=3" << "\n"
-//        << "STOREHOUSE id=1" << "\n"
-//        << "STOREHOUSE id=2" << "\n"
-//        << "LINK src=ramp-1 dest=store-1 p=0.3" << "\n"
-//        << "LINK src=ramp-1 dest=store-2 p=0.7" << "\n";
-//    std::istringstream iss(oss.str());
-//    auto factory = load_factory_structure(iss);
-//
-//    ASSERT_EQ(std::next(factory.ramp_cbegin(), 1), factory.ramp_cend());
-//    const auto& r = *(factory.ramp_cbegin());
-//
-//    ASSERT_EQ(std::next(factory.storehouse_cbegin(), 2), factory.storehouse_cend());
-//    const auto& s1 = *(factory.storehouse_cbegin());
-//    const auto& s2 = *(std::next(factory.storehouse_cbegin(), 1));
-//
-//    auto prefs = r.receiver_preferences_.get_preferences();
-//    ASSERT_EQ(2U, prefs.size());
-//    auto key1 = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s1));
-//    auto key2 = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s2));
-//    ASSERT_NE(prefs.find(key1), prefs.end());
-//    ASSERT_NE(prefs.find(key2), prefs.end());
-//    EXPECT_DOUBLE_EQ(prefs[key1], 0.3);
-//    EXPECT_DOUBLE_EQ(prefs[key2], 0.7);
-//}
+TEST(FactoryIOTest, ParseLinkMultipleReceiversWithDefinedProbabilities) {
+    std::ostringstream oss;
+    oss << "LOADING_RAMP id=1 delivery-interval=3" << "\n"
+        << "STOREHOUSE id=1" << "\n"
+        << "STOREHOUSE id=2" << "\n"
+        << "LINK src=ramp-1 dest=store-1 p=0.3" << "\n"
+        << "LINK src=ramp-1 dest=store-2 p=0.7" << "\n";
+    std::istringstream iss(oss.str());
+    auto factory = load_factory_structure(iss);
+
+    ASSERT_EQ(std::next(factory.ramp_cbegin(), 1), factory.ramp_cend());
+    const auto& r = *(factory.ramp_cbegin());
+
+    ASSERT_EQ(std::next(factory.storehouse_cbegin(), 2), factory.storehouse_cend());
+    const auto& s1 = *(factory.storehouse_cbegin());
+    const auto& s2 = *(std::next(factory.storehouse_cbegin(), 1));
+
+    auto prefs = r.receiver_preferences_.get_preferences();
+    ASSERT_EQ(2U, prefs.size());
+    auto key1 = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s1));
+    auto key2 = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s2));
+    ASSERT_NE(prefs.find(key1), prefs.end());
+    ASSERT_NE(prefs.find(key2), prefs.end());
+    EXPECT_DOUBLE_EQ(prefs[key1], 0.3);
+    EXPECT_DOUBLE_EQ(prefs[key2], 0.7);
+}
 
 TEST(FactoryIOTest, LoadAndSaveTest) {
     std::string r1 = "LOADING_RAMP id=1 delivery-interval=3";
@@ -151,8 +212,10 @@ TEST(FactoryIOTest, LoadAndSaveTest) {
     std::string l4 = "LINK src=worker-1 dest=worker-1";
     std::string l5 = "LINK src=worker-1 dest=worker-2";
     std::string l6 = "LINK src=worker-2 dest=store-1";
+    // Waga 1/3 zapisana z pełną precyzją.
+    std::string l7 = "LINK src=worker-2 dest=worker-1 p=0.3";
 
-    std::set<std::string> input_set = {r1, r2, w1, w2, s1, l1, l2, l3, l4, l5, l6};
+    std::set<std::string> input_set = {r1, r2, w1, w2, s1, l1, l2, l3, l4, l5, l6, l7};
 
     std::vector<std::string> input_lines{
             "; == LOADING RAMPS ==",
@@ -180,6 +243,7 @@ TEST(FactoryIOTest, LoadAndSaveTest) {
             l5,
             "",
             l6,
+            l7,
     };
 
     // ignore empty lines, ignore comments ("; ...")
@@ -243,3 +307,72 @@ TEST(FactoryIOTest, LoadAndSaveTest) {
     ASSERT_LT(first_worker_it, first_storehouse_it);
     ASSERT_LT(first_storehouse_it, first_link_it);
 }
+
+TEST(FactoryIOTest, SaveWritesOnlyNonDefaultWeights) {
+    std::istringstream iss("LOADING_RAMP id=1 delivery-interval=3\n"
+                           "STOREHOUSE id=1\n"
+                           "STOREHOUSE id=2\n"
+                           "LINK src=ramp-1 dest=store-1 p=3\n"
+                           "LINK src=ramp-1 dest=store-2\n");
+    auto factory = load_factory_structure(iss);
+
+    const auto& prefs = factory.ramp_cbegin()->receiver_preferences_.get_preferences();
+    EXPECT_DOUBLE_EQ(prefs.at(&*factory.find_storehouse_by_id(1)), 0.75);
+    EXPECT_DOUBLE_EQ(prefs.at(&*factory.find_storehouse_by_id(2)), 0.25);
+
+    std::ostringstream oss;
+    save_factory_structure(factory, oss);
+    EXPECT_NE(oss.str().find("LINK src=ramp-1 dest=store-1 p=3\n"), std::string::npos);
+    EXPECT_NE(oss.str().find("LINK src=ramp-1 dest=store-2\n"), std::string::npos);
+}
+
+TEST(FactoryIOTest, SaveAndLoadPreserveWeightsExactly) {
+    FactoryBuilder builder;
+    builder.add_ramp({1, 1});
+    builder.add_storehouse({1});
+    builder.add_storehouse({2});
+    builder.add_link({ElementType::RAMP, 1, ReceiverType::STOREHOUSE, 1, 1.0 / 3.0});
+    builder.add_link({ElementType::RAMP, 1, ReceiverType::STOREHOUSE, 2, 2.0 / 7.0});
+    auto factory = builder.build();
+
+    std::ostringstream first;
+    save_factory_structure(factory, first);
+    std::istringstream iss(first.str());
+    auto reloaded = load_factory_structure(iss);
+
+    const auto& weights = reloaded.ramp_cbegin()->receiver_preferences_.get_weights();
+    EXPECT_EQ(weights.at(&*reloaded.find_storehouse_by_id(1)), 1.0 / 3.0);
+    EXPECT_EQ(weights.at(&*reloaded.find_storehouse_by_id(2)), 2.0 / 7.0);
+
+    std::ostringstream second;
+    save_factory_structure(reloaded, second);
+    EXPECT_EQ(second.str(), first.str());
+}
+
+TEST(FactoryIOTest, SaveKeepsInsertionOrderAfterRemoval) {
+    std::ostringstream oss;
+    for (ElementID id = 1; id <= 4; ++id) {
+        oss << "LOADING_RAMP id=" << id << " delivery-interval=1" << "\n";
+        oss << "WORKER id=" << id << " processing-time=1 queue-type=FIFO" << "\n";
+        oss << "LINK src=ramp-" << id << " dest=worker-" << id << "\n";
+        oss << "LINK src=worker-" << id << " dest=store-1" << "\n";
+    }
+    oss << "STOREHOUSE id=1" << "\n";
+    std::istringstream iss(oss.str());
+    auto factory = load_factory_structure(iss);
+
+    factory.remove_ramp(2);
+    factory.remove_worker(1);
+
+    std::ostringstream saved;
+    save_factory_structure(factory, saved);
+    std::vector<std::string> nodes;
+    std::istringstream lines(saved.str());
+    for (std::string line; std::getline(lines, line);) {
+        if (line.rfind("LOADING_RAMP", 0) == 0 || line.rfind("WORKER", 0) == 0) {
+            nodes.push_back(line.substr(0, line.find(' ', line.find("id="))));
+        }
+    }
+    EXPECT_EQ(nodes, std::vector<std::string>({"LOADING_RAMP id=1", "LOADING_RAMP id=3", "LOADING_RAMP id=4",
+                                               "WORKER id=2", "WORKER id=3", "WORKER id=4"}));
+}
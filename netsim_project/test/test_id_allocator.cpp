@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+
+#include "id_allocator.hpp"
+
+TEST(IdAllocatorTest, AllocatesConsecutiveIds) {
+    IdAllocator ids;
+
+    EXPECT_EQ(ids.allocate(), 1);
+    EXPECT_EQ(ids.allocate(), 2);
+    EXPECT_EQ(ids.allocate(), 3);
+    EXPECT_EQ(ids.size(), 3U);
+}
+
+TEST(IdAllocatorTest, ReusesLowestReleasedId) {
+    IdAllocator ids;
+    for (int i = 0; i < 10; ++i) {
+        ids.allocate();
+    }
+
+    ids.release(7);
+    ids.release(3);
+    ids.release(9);
+
+    EXPECT_EQ(ids.allocate(), 3);
+    EXPECT_EQ(ids.allocate(), 7);
+    EXPECT_EQ(ids.allocate(), 9);
+    EXPECT_EQ(ids.allocate(), 11);
+}
+
+TEST(IdAllocatorTest, ReusesLowestIdAcrossLevels) {
+    // Więcej niż 64 * 64 ID -- mapa bitowa ma co najmniej trzy poziomy.
+    IdAllocator ids;
+    const int n = 64 * 64 * 3;
+    for (int i = 0; i < n; ++i) {
+        ASSERT_EQ(ids.allocate(), i + 1);
+    }
+
+    ids.release(n - 5);
+    ids.release(5000);
+    ids.release(70);
+
+    EXPECT_EQ(ids.allocate(), 70);
+    EXPECT_EQ(ids.allocate(), 5000);
+    EXPECT_EQ(ids.allocate(), n - 5);
+    EXPECT_EQ(ids.allocate(), n + 1);
+}
+
+TEST(IdAllocatorTest, ReserveSkipsExplicitId) {
+    IdAllocator ids;
+    ids.reserve(2);
+
+    EXPECT_TRUE(ids.is_assigned(2));
+    EXPECT_FALSE(ids.is_assigned(1));
+    EXPECT_EQ(ids.allocate(), 1);
+    EXPECT_EQ(ids.allocate(), 3);
+}
+
+TEST(IdAllocatorTest, ReleaseIsIdempotent) {
+    IdAllocator ids;
+    ids.allocate();
+    ids.release(1);
+    ids.release(1);
+    ids.release(42);
+
+    EXPECT_EQ(ids.size(), 0U);
+    EXPECT_EQ(ids.allocate(), 1);
+}
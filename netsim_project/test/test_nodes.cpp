@@ -34,6 +34,33 @@ TEST(WorkerTest, HasBuffer) {
     EXPECT_EQ(buffer.value().get_id(), 1);
 }
 
+TEST(WorkerTest, IsCapacityLimitingQueue) {
+    Worker w(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO), 2);
+
+    EXPECT_TRUE(w.can_receive_package());
+    w.receive_package(Package(1));
+    w.receive_package(Package(2));
+
+    EXPECT_FALSE(w.can_receive_package());
+    EXPECT_THROW(w.receive_package(Package(3)), std::length_error);
+    EXPECT_EQ(w.get_queue()->size(), 2U);
+}
+
+TEST(WorkerTest, IsWaitingForFreeSendingBuffer) {
+    // Przetworzony półprodukt zostaje w buforze przetwarzania, dopóki bufor wysyłkowy jest zajęty.
+    Worker w(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO));
+    w.receive_package(Package(1));
+    w.receive_package(Package(2));
+
+    w.do_work(1);
+    w.do_work(2);
+
+    ASSERT_TRUE(w.get_sending_buffer().has_value());
+    EXPECT_EQ(w.get_sending_buffer()->get_id(), 1);
+    ASSERT_TRUE(w.get_processing_buffer().has_value());
+    EXPECT_EQ(w.get_processing_buffer()->get_id(), 2);
+}
+
 // -----------------
 
 TEST(RampTest, IsDeliveryOnTime) {
@@ -85,6 +112,28 @@ TEST(ReceiverPreferencesTest, RemoveReceiversRescalesProbability) {
     EXPECT_EQ(rp.get_preferences().at(&r1), 1.0);
 }
 
+TEST(ReceiverPreferencesTest, AreWeightsNormalizedLazily) {
+    ReceiverPreferences rp;
+    MockReceiver r1, r2, r3;
+    rp.add_receiver(&r1, 1.0);
+    rp.add_receiver(&r2, 3.0);
+    rp.add_receiver(&r3, 0.0);
+
+    EXPECT_DOUBLE_EQ(rp.get_weights().at(&r2), 3.0);
+    EXPECT_DOUBLE_EQ(rp.get_preferences().at(&r1), 0.25);
+    EXPECT_DOUBLE_EQ(rp.get_preferences().at(&r2), 0.75);
+    EXPECT_DOUBLE_EQ(rp.get_preferences().at(&r3), 0.0);
+
+    // Ponowne dodanie zmienia tylko wagę.
+    rp.add_receiver(&r2, 1.0);
+    rp.remove_receiver(&r3);
+    ASSERT_EQ(rp.get_preferences().size(), 2U);
+    EXPECT_DOUBLE_EQ(rp.get_preferences().at(&r2), 0.5);
+
+    EXPECT_THROW(rp.add_receiver(&r3, -1.0), std::invalid_argument);
+    EXPECT_EQ(rp.get_weights().count(&r3), 0U);
+}
+
 // Przydatny alias, żeby zamiast pisać `::testing::Return(...)` móc pisać
 // samo `Return(...)`.
 using ::testing::Return;
@@ -115,6 +164,53 @@ TEST_F(ReceiverPreferencesChoosingTest, ChooseReceiver) {
     }
 }
 
+TEST_F(ReceiverPreferencesChoosingTest, SingleReceiverSkipsDraw) {
+    EXPECT_CALL(global_functions_mock, generate_canonical()).Times(0);
+
+    ReceiverPreferences rp;
+    MockReceiver r;
+    rp.add_receiver(&r);
+
+    EXPECT_EQ(rp.choose_receiver(), &r);
+    EXPECT_EQ(rp.choose_receiver(), &r);
+}
+
+TEST_F(ReceiverPreferencesChoosingTest, ChooseReceiverNeverReturnsNullptr) {
+    // Wartości brzegowe i spoza [0, 1] nie mogą dać pustego wyniku.
+    EXPECT_CALL(global_functions_mock, generate_canonical())
+            .WillOnce(Return(0.0)).WillOnce(Return(1.0)).WillOnce(Return(1.5)).WillOnce(Return(-0.1))
+            .WillOnce(Return(0.99999999999999989));
+
+    ReceiverPreferences rp;
+    MockReceiver r1, r2, r3;
+    rp.add_receiver(&r1);
+    rp.add_receiver(&r2);
+    rp.add_receiver(&r3);
+
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_NE(rp.choose_receiver(), nullptr);
+    }
+    EXPECT_EQ(ReceiverPreferences().choose_receiver(), nullptr);
+}
+
+TEST(AliasTableTest, IsDistributionPreserved) {
+    std::vector<double> weights = {1.0, 2.0, 3.0, 4.0, 0.0};
+    std::vector<AliasColumn> columns;
+    build_alias_table(weights, columns);
+    ASSERT_EQ(columns.size(), weights.size());
+
+    // Każda kolumna to 1/n masy: `probability` dla niej samej, reszta dla aliasu.
+    std::vector<double> mass(weights.size(), 0.0);
+    auto n = double(weights.size());
+    for (std::size_t c = 0; c < columns.size(); ++c) {
+        mass[c] += columns[c].probability / n;
+        mass[columns[c].alias] += (1.0 - columns[c].probability) / n;
+    }
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+        EXPECT_NEAR(mass[i], weights[i] / 10.0, 1e-12);
+    }
+}
+
 // -----------------
 
 using ::testing::Return;
@@ -159,3 +255,76 @@ TEST(PackageSenderTest, SendPackage) {
     // Upewnij się, że proces wysyłania zachodzi tylko wówczas, gdy w bufor jest pełny.
     sender.send_package();
 }
+
+TEST(RampTest, DeliversOnFirstTurnAndEveryInterval) {
+    Ramp r(1, 3);
+    Storehouse s(1);
+    r.receiver_preferences_.add_receiver(&s);
+
+    std::vector<Time> deliveries;
+    for (Time t = 1; t <= 7; ++t) {
+        r.deliver_goods(t);
+        if (r.get_sending_buffer()) {
+            deliveries.push_back(t);
+        }
+        r.send_package();
+    }
+    EXPECT_EQ(deliveries, std::vector<Time>({1, 4, 7}));
+}
+
+TEST(WorkerTest, FinishesAfterProcessingDuration) {
+    Worker w(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO));
+    Package first;
+    auto first_id = first.get_id();
+    w.receive_package(std::move(first));
+    w.receive_package(Package());
+
+    w.do_work(1);
+    EXPECT_FALSE(w.get_sending_buffer());
+    ASSERT_TRUE(w.get_processing_buffer());
+    EXPECT_EQ(w.get_processing_buffer()->get_id(), first_id);
+
+    // Druga tura przetwarzania kończy pracę; kolejny półprodukt pobierany jest w następnej turze.
+    w.do_work(2);
+    ASSERT_TRUE(w.get_sending_buffer());
+    EXPECT_EQ(w.get_sending_buffer()->get_id(), first_id);
+    EXPECT_FALSE(w.get_processing_buffer());
+}
+
+TEST(WorkerTest, SingleTurnProcessingFinishesInSameTurn) {
+    Worker w(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO));
+    w.receive_package(Package());
+
+    w.do_work(1);
+    EXPECT_TRUE(w.get_sending_buffer());
+    EXPECT_FALSE(w.get_processing_buffer());
+}
+
+TEST(PackageSenderTest, KeepPackageWhenReceiverIsFull) {
+    Worker receiver(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO), 1);
+    receiver.receive_package(Package(1));
+
+    PackageSenderFixture sender;
+    sender.receiver_preferences_.add_receiver(&receiver);
+    sender.push_package(Package(2));
+
+    sender.send_package();
+    ASSERT_TRUE(sender.get_sending_buffer().has_value());
+    EXPECT_EQ(sender.get_sending_buffer()->get_id(), 2);
+
+    // Po zwolnieniu miejsca w kolejce wysyłka zostaje ponowiona.
+    receiver.do_work(1);
+    sender.send_package();
+    EXPECT_FALSE(sender.get_sending_buffer());
+    EXPECT_EQ(receiver.get_queue()->size(), 1U);
+}
+
+TEST(RampTest, IsDeliverySkippedWhenBufferIsFull) {
+    Ramp r(1, 1);
+    r.deliver_goods(1);
+    ASSERT_TRUE(r.get_sending_buffer().has_value());
+    ElementID first = r.get_sending_buffer()->get_id();
+
+    r.deliver_goods(2);
+    EXPECT_EQ(r.get_sending_buffer()->get_id(), first);
+}
@@ -38,3 +38,32 @@ TEST(PackageTest, IsAssignmentOperatorCorrect) {
 
     EXPECT_EQ(p2.get_id(), 1);
 }
+
+TEST(PackageTest, IsMovedFromPackageEmpty) {
+    // Przeniesienie nie zwalnia ID -- nowy półprodukt nie może dostać ID przeniesionego.
+
+    Package p1;
+    {
+        Package p2(std::move(p1));
+        Package p3;
+
+        EXPECT_EQ(p1.get_id(), Package::EMPTY_ID);
+        EXPECT_EQ(p2.get_id(), 1);
+        EXPECT_EQ(p3.get_id(), 2);
+    }
+    Package p4;
+
+    EXPECT_EQ(p4.get_id(), 1);
+}
+
+TEST(PackageTest, IsMoveAssignmentReleasingOverwrittenId) {
+    Package p1;
+    Package p2;
+    p1 = std::move(p2);
+
+    EXPECT_EQ(p1.get_id(), 2);
+    EXPECT_EQ(p2.get_id(), Package::EMPTY_ID);
+
+    Package p3;
+    EXPECT_EQ(p3.get_id(), 1);
+}
@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+
+#include "package.hpp"
+#include "package_slab.hpp"
+#include "simulation_context.hpp"
+
+TEST(PackageSlabTest, PackageIsHandleIntoCurrentSlab) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+
+    Package p1;
+    Package p2;
+
+    EXPECT_EQ(sizeof(Package), 4U);
+    EXPECT_TRUE(context.packages().contains(p1.get_id()));
+    EXPECT_TRUE(context.packages().contains(p2.get_id()));
+    EXPECT_EQ(context.packages().size(), 2U);
+}
+
+TEST(PackageSlabTest, AttributesDisabledByDefault) {
+    PackageSlab slab;
+    auto id = slab.create();
+    slab.record_origin(id, 3, 1);
+    slab.count_hop(id);
+
+    EXPECT_FALSE(slab.is_enabled(PackageAttribute::CREATION_TURN));
+    EXPECT_FALSE(slab.get_creation_turn(id).has_value());
+    EXPECT_FALSE(slab.get_source_ramp(id).has_value());
+    EXPECT_FALSE(slab.get_hop_count(id).has_value());
+}
+
+TEST(PackageSlabTest, EnabledAttributesAreRecorded) {
+    PackageSlab slab;
+    slab.enable(PackageAttribute::CREATION_TURN);
+    slab.enable(PackageAttribute::HOP_COUNT);
+
+    auto id = slab.create();
+    slab.record_origin(id, 7, 2);
+    slab.count_hop(id);
+    slab.count_hop(id);
+
+    EXPECT_EQ(slab.get_creation_turn(id), 7);
+    EXPECT_EQ(slab.get_hop_count(id), 2U);
+    // Kolumna niewłączona nie jest alokowana.
+    EXPECT_FALSE(slab.get_source_ramp(id).has_value());
+}
+
+TEST(PackageSlabTest, ReusedSlotIsReset) {
+    PackageSlab slab;
+    slab.enable(PackageAttribute::HOP_COUNT);
+
+    auto id = slab.create();
+    slab.count_hop(id);
+    slab.destroy(id);
+
+    auto reused = slab.create();
+    ASSERT_EQ(reused, id);
+    EXPECT_EQ(slab.get_hop_count(reused), 0U);
+}
+
+TEST(PackageSlabTest, EnableAfterCreationCoversExistingSlots) {
+    PackageSlab slab;
+    for (int i = 0; i < 100; ++i) {
+        slab.create();
+    }
+    slab.enable(PackageAttribute::SOURCE_RAMP);
+    slab.record_origin(100, 1, 5);
+
+    EXPECT_EQ(slab.get_source_ramp(100), 5);
+    EXPECT_EQ(slab.get_source_ramp(1), 0);
+}
@@ -368,3 +368,63 @@ TEST(ReportsTest, TurnReportPackageInStock) {
 
     perform_turn_report_check(factory, t, expected_report_lines);
 }
+
+TEST(ReportsTest, TurnReportCountsProcessingTimeFromOne) {
+    Factory factory;
+    factory.add_worker(Worker(1, 3, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+
+    Worker& w = *(factory.find_worker_by_id(1));
+    w.receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+    w.receive_package(Package());
+
+    for (Time t = 1; t <= 2; ++t) {
+        w.do_work(t);
+        ASSERT_TRUE(w.get_processing_buffer());
+        auto expected = "  PBuffer: #" + std::to_string(w.get_processing_buffer()->get_id())
+                        + " (pt = " + std::to_string(t) + ")\n";
+
+        std::ostringstream oss;
+        generate_simulation_turn_report(factory, oss, t);
+        EXPECT_NE(oss.str().find(expected), std::string::npos) << oss.str();
+    }
+}
+
+TEST(ReportsTest, TurnReportSeveralPackagesInStock) {
+    // Magazyn z kolejką FIFO (nieposortowany zapas) oraz magazyn domyślny (mapa bitowa).
+    Factory factory;
+
+    factory.add_storehouse(Storehouse(1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(2));
+
+    Storehouse& s1 = *(factory.find_storehouse_by_id(1));
+    Storehouse& s2 = *(factory.find_storehouse_by_id(2));
+    for (ElementID id : {3, 1, 2}) {
+        s1.receive_package(Package(id));
+    }
+    for (ElementID id : {6, 4, 5}) {
+        s2.receive_package(Package(id));
+    }
+
+    Time t = 1;
+
+    // -----------------------------------------------------------------------
+
+    std::vector<std::string> expected_report_lines{
+            "=== [ Turn: " + std::to_string(t) + " ] ===",
+            "",
+            "== WORKERS ==",
+            "",
+            "",
+            "== STOREHOUSES ==",
+            "",
+            "STOREHOUSE #1",
+            "  Stock: #1, #2, #3",
+            "",
+            "STOREHOUSE #2",
+            "  Stock: #4, #5, #6",
+            "",
+    };
+
+    perform_turn_report_check(factory, t, expected_report_lines);
+}
@@ -3,7 +3,6 @@
 
 #include "nodes.hpp"
 #include "simulation.hpp"
-#include "helpers.hpp"
 #include "reports.hpp"
 
 using ::testing::Return;
@@ -35,3 +34,223 @@ TEST(SimulationTest, Simulate) {
     ASSERT_NE(storehouse_it->cbegin(), storehouse_it->cend());
     EXPECT_EQ(storehouse_it->cbegin()->get_id(), 1);
 }
+
+TEST(SimulationTest, RecordsEnabledPackageAttributes) {
+    SimulationContext context;
+    context.packages().enable(PackageAttribute::CREATION_TURN);
+    context.packages().enable(PackageAttribute::SOURCE_RAMP);
+    context.packages().enable(PackageAttribute::HOP_COUNT);
+
+    Factory factory(context);
+    factory.add_ramp(Ramp(3, 10));
+    factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+
+    Ramp& r = *(factory.find_ramp_by_id(3));
+    r.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(1)));
+
+    Worker& w = *(factory.find_worker_by_id(1));
+    w.receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+
+    simulate(factory, 3, [](Factory&, TimeOffset) {});
+
+    auto storehouse_it = factory.storehouse_cbegin();
+    ASSERT_NE(storehouse_it->cbegin(), storehouse_it->cend());
+    ElementID id = storehouse_it->cbegin()->get_id();
+    EXPECT_EQ(context.packages().get_creation_turn(id), 1);
+    EXPECT_EQ(context.packages().get_source_ramp(id), 3);
+    EXPECT_EQ(context.packages().get_hop_count(id), 2U);
+}
+
+TEST(SimulationTest, OverloadedWorkerQueueStaysBounded) {
+    // R (co turę) -> W (5 tur na półprodukt, kolejka na 3) -> S
+    SimulationContext context;
+    Factory factory(context);
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_worker(Worker(1, 5, std::make_unique<PackageQueue>(PackageQueueType::FIFO), 3));
+    factory.add_storehouse(Storehouse(1));
+
+    Ramp& r = *(factory.find_ramp_by_id(1));
+    r.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(1)));
+
+    Worker& w = *(factory.find_worker_by_id(1));
+    w.receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+
+    simulate(factory, 100, [](Factory&, TimeOffset) {});
+
+    EXPECT_EQ(w.get_queue()->size(), 3U);
+    auto stored = std::size_t(std::distance(factory.storehouse_cbegin()->cbegin(), factory.storehouse_cbegin()->cend()));
+    EXPECT_EQ(stored, 19U);
+    // Rampa + kolejka + bufory robotnika + magazyn.
+    EXPECT_LE(context.packages().size(), 1U + 3U + 2U + stored);
+}
+
+namespace {
+    // R -> W1 (kolejka na 2) -> W2 -> S
+    void build_chain(Factory& factory) {
+        factory.add_ramp(Ramp(1, 1));
+        factory.add_worker(Worker(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO), 2));
+        factory.add_worker(Worker(2, 3, std::make_unique<PackageQueue>(PackageQueueType::LIFO)));
+        factory.add_storehouse(Storehouse(1));
+
+        factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(1)));
+        factory.find_worker_by_id(1)->receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(2)));
+        factory.find_worker_by_id(2)->receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+    }
+
+    std::vector<ElementID> stock_ids(const Factory& factory) {
+        std::vector<ElementID> ids;
+        for (const auto& p : *factory.storehouse_cbegin()) {
+            ids.push_back(p.get_id());
+        }
+        return ids;
+    }
+}
+
+TEST(SimulationTest, CompiledGraphMatchesNodeLoops) {
+    SimulationContext context_nodes;
+    Factory by_nodes(context_nodes);
+    build_chain(by_nodes);
+    for (Time t = 1; t <= 50; ++t) {
+        by_nodes.do_deliveries(t);
+        by_nodes.do_package_passing();
+        by_nodes.do_work(t);
+    }
+
+    SimulationContext context_graph;
+    Factory by_graph(context_graph);
+    build_chain(by_graph);
+    simulate(by_graph, 50, [](Factory&, TimeOffset) {});
+
+    EXPECT_FALSE(stock_ids(by_graph).empty());
+    EXPECT_EQ(stock_ids(by_graph), stock_ids(by_nodes));
+    EXPECT_EQ(context_graph.packages().size(), context_nodes.packages().size());
+}
+
+TEST(SimulationTest, CompiledGraphMatchesNodeLoopsForEveryDiscipline) {
+    // R -> {W1 (priorytet), W2 (LIFO)} -> {S1 (bitmapa), S2 (kolejka)}
+    auto build = [](Factory& factory) {
+        factory.add_ramp(Ramp(1, 1));
+        factory.add_worker(Worker(1, 3, std::make_unique<PriorityPackageQueue>(), 2));
+        factory.add_worker(Worker(2, 2, std::make_unique<PackageQueue>(PackageQueueType::LIFO)));
+        factory.add_storehouse(Storehouse(1, StockpileType::BITMAP));
+        factory.add_storehouse(Storehouse(2, StockpileType::QUEUE));
+        for (ElementID w = 1; w <= 2; ++w) {
+            factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(w)));
+            for (ElementID s = 1; s <= 2; ++s) {
+                factory.find_worker_by_id(w)->receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(s)));
+            }
+        }
+    };
+    auto stocks = [](const Factory& factory) {
+        std::vector<std::vector<ElementID>> ids;
+        for (auto it = factory.storehouse_cbegin(); it != factory.storehouse_cend(); ++it) {
+            ids.emplace_back();
+            for (const auto& p : *it) {
+                ids.back().push_back(p.get_id());
+            }
+        }
+        return ids;
+    };
+
+    SimulationContext context_nodes(7);
+    Factory by_nodes(context_nodes);
+    build(by_nodes);
+    for (Time t = 1; t <= 60; ++t) {
+        by_nodes.do_deliveries(t);
+        by_nodes.do_package_passing();
+        by_nodes.do_work(t);
+    }
+
+    SimulationContext context_graph(7);
+    Factory by_graph(context_graph);
+    build(by_graph);
+    auto graph = by_graph.compile();
+    for (Time t = 1; t <= 60; ++t) {
+        graph.do_deliveries(t);
+        graph.do_package_passing();
+        graph.do_work(t);
+    }
+
+    EXPECT_FALSE(stocks(by_graph)[0].empty());
+    EXPECT_FALSE(stocks(by_graph)[1].empty());
+    EXPECT_EQ(stocks(by_graph), stocks(by_nodes));
+}
+
+TEST(SimulationTest, CompiledGraphRoutesByPreferences) {
+    // R -> {W1, W2} -> S
+    SimulationContext context;
+    Factory factory(context);
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_worker(Worker(2, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+
+    auto& r = *factory.find_ramp_by_id(1);
+    r.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(1)));
+    r.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(2)));
+    factory.find_worker_by_id(1)->receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+    factory.find_worker_by_id(2)->receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+
+    // Generator zwraca na przemian 0.3 i 0.7.
+    int draw = 0;
+    context.set_probability_generator([&draw]() { return (draw++ % 2) ? 0.7 : 0.3; });
+
+    auto graph = factory.compile();
+    EXPECT_EQ(graph.sender_count(), 3U);
+    EXPECT_EQ(graph.edge_count(), 4U);
+    for (Time t = 1; t <= 4; ++t) {
+        graph.do_deliveries(t);
+        graph.do_package_passing();
+        if (t == 1) {
+            // Rampa wylosowała 0.3 -- pierwszy odbiorca w kolejności preferencji.
+            const IPackageReceiver* expected = r.receiver_preferences_.begin()->first;
+            EXPECT_EQ(expected->cbegin()->get_id(), 1);
+        }
+        graph.do_work(t);
+    }
+    EXPECT_EQ(std::distance(factory.storehouse_cbegin()->cbegin(), factory.storehouse_cbegin()->cend()), 3);
+}
+
+TEST(SimulationTest, CompiledGraphDispatchesLibraryReceiversDirectly) {
+    // R -> {W1 (LIFO), W2 (PRIORITY)} -> {S1 (domyślny zapas), S2 (mapa bitowa)}
+    SimulationContext context;
+    Factory factory(context);
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::LIFO)));
+    factory.add_worker(Worker(2, 1, std::make_unique<PriorityPackageQueue>()));
+    factory.add_storehouse(Storehouse(1));
+    factory.add_storehouse(Storehouse(2, std::make_unique<BitmapStockpile>()));
+
+    auto& r = *factory.find_ramp_by_id(1);
+    for (ElementID w = 1; w <= 2; ++w) {
+        r.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(w)));
+        for (ElementID s = 1; s <= 2; ++s) {
+            factory.find_worker_by_id(w)->receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(s)));
+        }
+    }
+
+    auto graph = factory.compile();
+    EXPECT_EQ(graph.edge_count(), 6U);
+    EXPECT_EQ(graph.virtual_edge_count(), 0U);
+
+    for (Time t = 1; t <= 10; ++t) {
+        graph.do_deliveries(t);
+        graph.do_package_passing();
+        graph.do_work(t);
+    }
+    auto stock = [&factory](ElementID id) {
+        const auto& s = *factory.find_storehouse_by_id(id);
+        return std::distance(s.cbegin(), s.cend());
+    };
+    EXPECT_EQ(stock(1) + stock(2), 9);
+}
+
+TEST(SimulationTest, CompileRejectsForeignReceiver) {
+    Factory factory;
+    Storehouse outside(7);
+    factory.add_ramp(Ramp(1, 1));
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&outside);
+
+    EXPECT_THROW(factory.compile(), std::logic_error);
+}
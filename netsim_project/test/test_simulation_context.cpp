@@ -0,0 +1,275 @@
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "package.hpp"
+#include "reports.hpp"
+#include "simulation.hpp"
+#include "simulation_context.hpp"
+
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace {
+    Factory make_factory(SimulationContext& context) {
+        // R1 -> W1 -> S1
+        // R2 -> W2 -> S1
+        Factory factory(context);
+        factory.add_ramp(Ramp(1, 1));
+        factory.add_ramp(Ramp(2, 3));
+        factory.add_worker(Worker(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        factory.add_worker(Worker(2, 1, std::make_unique<PackageQueue>(PackageQueueType::LIFO)));
+        factory.add_storehouse(Storehouse(1));
+
+        for (ElementID id : {1, 2}) {
+            Ramp& r = *(factory.find_ramp_by_id(id));
+            r.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(id)));
+
+            Worker& w = *(factory.find_worker_by_id(id));
+            w.receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+        }
+        return factory;
+    }
+
+    std::string run_simulation(SimulationContext& context, TimeOffset d) {
+        Factory factory = make_factory(context);
+        std::ostringstream oss;
+        simulate(factory, d, [](Factory&, Time) {});
+        generate_simulation_turn_report(factory, oss, d);
+        return oss.str();
+    }
+}
+
+TEST(SimulationContextTest, ContextsHaveSeparateIdSpaces) {
+    SimulationContext c1;
+    SimulationContext c2;
+
+    SimulationContext::Scope s1(c1);
+    Package p1;
+    Package p2;
+    {
+        SimulationContext::Scope s2(c2);
+        Package p3;
+        EXPECT_EQ(p3.get_id(), 1);
+    }
+    EXPECT_EQ(p1.get_id(), 1);
+    EXPECT_EQ(p2.get_id(), 2);
+    EXPECT_EQ(c2.packages().size(), 0U);
+}
+
+TEST(SimulationContextTest, ScopeRestoresPreviousContext) {
+    SimulationContext& default_context = SimulationContext::current();
+    SimulationContext c;
+    {
+        SimulationContext::Scope scope(c);
+        EXPECT_EQ(&SimulationContext::current(), &c);
+    }
+    EXPECT_EQ(&SimulationContext::current(), &default_context);
+}
+
+TEST(SimulationContextTest, ReceiverPreferencesDrawFromBoundContext) {
+    SimulationContext c;
+    c.set_probability_generator([]() { return 0.9; });
+
+    Storehouse s1(1);
+    Storehouse s2(2);
+    ReceiverPreferences rp(c);
+    rp.add_receiver(&s1);
+    rp.add_receiver(&s2);
+
+    IPackageReceiver* last = std::prev(rp.get_weights().end())->first;
+    EXPECT_EQ(rp.choose_receiver(), last);
+}
+
+TEST(SimulationContextTest, FactoryReleasesPackagesIntoItsContext) {
+    auto assigned_in_default = SimulationContext::current().packages().size();
+    SimulationContext c;
+    {
+        Factory factory = make_factory(c);
+        simulate(factory, 5, [](Factory&, Time) {});
+        EXPECT_GT(c.packages().size(), 0U);
+    }
+    EXPECT_EQ(c.packages().size(), 0U);
+    EXPECT_EQ(SimulationContext::current().packages().size(), assigned_in_default);
+}
+
+TEST(SimulationContextTest, RemovingNodeReleasesPackagesIntoFactoryContext) {
+    auto assigned_in_default = SimulationContext::current().packages().size();
+    SimulationContext c;
+    Factory factory = make_factory(c);
+    simulate(factory, 6, [](Factory&, Time) {});
+
+    // W1 (czas przetwarzania 2, dostawa co turę) ma zaległości w kolejce.
+    const auto& w1 = *factory.find_worker_by_id(1);
+    ASSERT_GT(w1.get_queue()->size(), 0U);
+    auto assigned = c.packages().size();
+
+    factory.remove_worker(1);
+    EXPECT_LT(c.packages().size(), assigned);
+    EXPECT_EQ(SimulationContext::current().packages().size(), assigned_in_default);
+}
+
+TEST(SimulationContextTest, OwnersReleasePackagesIntoTheirContextOutsideScope) {
+    auto assigned_in_default = SimulationContext::current().packages().size();
+    SimulationContext c;
+    {
+        Worker w(1, 1, make_package_queue(PackageQueueType::PRIORITY, c));
+        w.receiver_preferences_.bind(c);
+        Storehouse s(1, StockpileType::BITMAP, c);
+        {
+            SimulationContext::Scope scope(c);
+            w.receive_package(Package());
+            w.receive_package(Package());
+            s.receive_package(Package());
+            w.do_work(1);
+        }
+        ASSERT_TRUE(w.get_sending_buffer());
+        EXPECT_EQ(c.packages().size(), 3U);
+    }
+    // Robotnik (bufor i kolejka) oraz magazyn zniszczone poza zakresem kontekstu `c`.
+    EXPECT_EQ(c.packages().size(), 0U);
+    EXPECT_EQ(SimulationContext::current().packages().size(), assigned_in_default);
+}
+
+TEST(SimulationContextTest, FactoryRebindsOnlyEmptyNodes) {
+    SimulationContext c;
+    Factory factory(c);
+    Storehouse empty(1);
+    factory.add_storehouse(std::move(empty));
+    EXPECT_EQ(&factory.find_storehouse_by_id(1)->get_stockpile().context(), &c);
+
+    Storehouse stocked(2);
+    stocked.receive_package(Package());
+    EXPECT_THROW(factory.add_storehouse(std::move(stocked)), std::logic_error);
+}
+
+TEST(SimulationContextTest, IndependentSimulationsOnSeparateThreads) {
+    // Symulacje w osobnych wątkach nie współdzielą stanu -- każda daje ten sam wynik co przebieg referencyjny.
+    const TimeOffset d = 50;
+    SimulationContext reference_context(7);
+    std::string reference = run_simulation(reference_context, d);
+
+    std::string results[2];
+    std::thread threads[2];
+    for (int i = 0; i < 2; ++i) {
+        threads[i] = std::thread([&results, i, d]() {
+            SimulationContext context(7);
+            results[i] = run_simulation(context, d);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(results[0], reference);
+    EXPECT_EQ(results[1], reference);
+}
+
+TEST(SimulationContextTest, DefaultDrawsAreSeededAndCanonical) {
+    SimulationContext a(11);
+    SimulationContext b(11);
+    SimulationContext c(12);
+    int differing = 0;
+    for (int i = 0; i < 1000; ++i) {
+        auto x = a.generate_probability();
+        EXPECT_GE(x, 0.0);
+        EXPECT_LT(x, 1.0);
+        EXPECT_EQ(x, b.generate_probability());
+        differing += x != c.generate_probability();
+    }
+    EXPECT_GT(differing, 990);
+}
+
+TEST(SimulationContextTest, InjectedGeneratorOverridesEngineUntilReset) {
+    SimulationContext a(3);
+    SimulationContext b(3);
+
+    a.set_probability_generator([]() { return 0.25; });
+    EXPECT_EQ(a.generate_probability(), 0.25);
+    EXPECT_EQ(a.generate_probability(), 0.25);
+
+    // Atrapa nie zużywa stanu silnika.
+    a.reset_probability_generator();
+    EXPECT_EQ(a.generate_probability(), b.generate_probability());
+}
+
+TEST(PhiloxTest, MatchesKnownAnswers) {
+    // Wektory testowe z biblioteki Random123.
+    EXPECT_EQ(philox4x32({0, 0, 0, 0}, {0, 0}),
+              (philox_counter_t{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+    EXPECT_EQ(philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}),
+              (philox_counter_t{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+    EXPECT_EQ(philox4x32({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}),
+              (philox_counter_t{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+namespace {
+    // Wybory ramp (indeks magazynu) w kolejnych turach; `threads` wątków, każdy przechodzi swoje rampy od końca.
+    std::vector<std::vector<ElementID>> routing_choices(std::size_t threads) {
+        const int turns = 20;
+        const ElementID ramp_count = 64;
+        SimulationContext context(99);
+        std::vector<Storehouse> storehouses;
+        std::vector<Ramp> ramps;
+        {
+            SimulationContext::Scope scope(context);
+            for (ElementID id = 1; id <= 5; ++id) {
+                storehouses.emplace_back(id);
+            }
+            for (ElementID id = 1; id <= ramp_count; ++id) {
+                ramps.emplace_back(id, 1);
+                for (auto& s : storehouses) {
+                    ramps.back().receiver_preferences_.add_receiver(&s, double(s.get_id()));
+                }
+            }
+        }
+
+        std::vector<std::vector<ElementID>> choices(turns, std::vector<ElementID>(std::size_t(ramp_count)));
+        for (Time t = 1; t <= turns; ++t) {
+            context.set_turn(t);
+            auto& turn_choices = choices[std::size_t(t - 1)];
+            auto work = [&](std::size_t first) {
+                for (auto i = first; i < ramps.size(); i += threads) {
+                    auto r = ramps.size() - 1 - i;
+                    turn_choices[r] = ramps[r].receiver_preferences_.choose_receiver()->get_id();
+                }
+            };
+            std::vector<std::thread> pool;
+            for (std::size_t k = 0; k < threads; ++k) {
+                pool.emplace_back(work, k);
+            }
+            for (auto& thread : pool) {
+                thread.join();
+            }
+        }
+        return choices;
+    }
+}
+
+TEST(SimulationContextTest, KeyedDrawsDoNotDependOnOrderOrThreads) {
+    auto sequential = routing_choices(1);
+    EXPECT_EQ(routing_choices(4), sequential);
+    EXPECT_EQ(routing_choices(7), sequential);
+
+    // Wybory rzeczywiście się różnią między rampami i turami.
+    std::set<ElementID> seen(sequential[0].begin(), sequential[0].end());
+    EXPECT_GT(seen.size(), 1U);
+    EXPECT_NE(sequential[0], sequential[1]);
+}
+
+TEST(SimulationContextTest, KeyedDrawIsPureFunctionOfKey) {
+    SimulationContext a(5);
+    SimulationContext b(5);
+    a.set_turn(3);
+    b.set_turn(3);
+    auto stream = sender_stream(SenderKind::WORKER, 17);
+
+    // Losowania z innych strumieni i ze wspólnego generatora nie wpływają na wynik.
+    b.generate_probability();
+    b.generate_probability(sender_stream(SenderKind::RAMP, 17), 0);
+    EXPECT_EQ(a.generate_probability(stream, 0), b.generate_probability(stream, 0));
+    EXPECT_NE(a.generate_probability(stream, 0), a.generate_probability(stream, 1));
+
+    b.set_turn(4);
+    EXPECT_NE(a.generate_probability(stream, 0), b.generate_probability(stream, 0));
+}
@@ -0,0 +1,57 @@
+#include "gtest/gtest.h"
+
+#include "slot_map.hpp"
+
+#include <string>
+
+TEST(SlotMapTest, KeepsAddressesAndOrderAcrossErase) {
+    SlotMap<std::string> map;
+    std::vector<SlotHandle> handles;
+    for (int i = 0; i < 200; ++i) {
+        handles.push_back(map.insert(std::to_string(i)));
+    }
+    const std::string* last = map.get(handles[199]);
+
+    map.erase(handles[10]);
+    map.erase(handles[100]);
+
+    ASSERT_EQ(map.size(), 198U);
+    EXPECT_EQ(map.get(handles[199]), last);
+    EXPECT_EQ(*map.dense()[10], "11");
+    EXPECT_EQ(map.position(handles[101]), 99U);
+    std::size_t expected = 0;
+    for (int i = 0; i < 200; ++i) {
+        if (i != 10 && i != 100) {
+            EXPECT_EQ(map.position(handles[std::size_t(i)]), expected++);
+        }
+    }
+}
+
+TEST(SlotMapTest, ErasingEveryElementLeavesEmptyMap) {
+    SlotMap<int> map;
+    std::vector<SlotHandle> handles;
+    for (int i = 0; i < 1000; ++i) {
+        handles.push_back(map.insert(int(i)));
+    }
+    for (std::size_t i = 0; i < handles.size(); i += 2) {
+        map.erase(handles[i]);
+    }
+    ASSERT_EQ(map.size(), 500U);
+    for (std::size_t i = 1; i < handles.size(); i += 2) {
+        EXPECT_EQ(*map.get(handles[i]), int(i));
+        map.erase(handles[i]);
+    }
+    EXPECT_TRUE(map.empty());
+}
+
+TEST(SlotMapTest, RejectsStaleHandleAfterSlotReuse) {
+    SlotMap<std::string> map;
+    auto first = map.insert("a");
+    map.erase(first);
+    auto second = map.insert("b");
+
+    EXPECT_EQ(first.index, second.index);
+    EXPECT_FALSE(map.contains(first));
+    EXPECT_EQ(map.get(first), nullptr);
+    EXPECT_EQ(*map.get(second), "b");
+}
@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+
+#include "nodes.hpp"
+#include "small_flat_map.hpp"
+
+#include <random>
+#include <unordered_map>
+
+TEST(SmallFlatMapTest, StaysInlineUpToCapacity) {
+    SmallFlatMap<int, double, 4> map;
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(map.emplace(i, i * 0.5).second);
+    }
+    EXPECT_TRUE(map.is_inline());
+    EXPECT_FALSE(map.emplace(2, 7.0).second);
+    EXPECT_DOUBLE_EQ(map.at(2), 1.0);
+
+    map.emplace(4, 2.0);
+    EXPECT_FALSE(map.is_inline());
+    ASSERT_EQ(map.size(), 5U);
+    // Kolejność wstawiania przetrwała przeniesienie na stertę.
+    int expected = 0;
+    for (const auto& entry : map) {
+        EXPECT_EQ(entry.first, expected++);
+    }
+}
+
+TEST(SmallFlatMapTest, MatchesStdMapUnderRandomEdits) {
+    // Przekracza próg indeksu mieszającego i wraca poniżej niego.
+    SmallFlatMap<int, int> map;
+    std::unordered_map<int, int> expected;
+    std::mt19937 rng(5);
+    for (int step = 0; step < 5000; ++step) {
+        int key = std::uniform_int_distribution<int>(0, 40)(rng);
+        if (rng() % 3 == 0) {
+            EXPECT_EQ(map.erase(key), expected.erase(key));
+        } else {
+            map.insert_or_assign(key, step);
+            expected[key] = step;
+        }
+        ASSERT_EQ(map.size(), expected.size());
+    }
+    for (const auto& entry : expected) {
+        ASSERT_NE(map.find(entry.first), map.end());
+        EXPECT_EQ(map.at(entry.first), entry.second);
+    }
+
+    auto copy = map;
+    copy.erase(copy.begin()->first);
+    EXPECT_EQ(copy.size() + 1, map.size());
+    EXPECT_THROW(map.at(1000), std::out_of_range);
+}
+
+TEST(SmallFlatMapTest, SmallFanOutNeedsNoHeapStorage) {
+    Storehouse s1(1), s2(2), s3(3), s4(4);
+    ReceiverPreferences rp;
+    for (auto s : {&s1, &s2, &s3, &s4}) {
+        rp.add_receiver(s);
+    }
+    EXPECT_TRUE(rp.get_weights().is_inline());
+    EXPECT_NE(rp.choose_receiver(), nullptr);
+    EXPECT_DOUBLE_EQ(rp.get_preferences().at(&s1), 0.25);
+    EXPECT_TRUE(rp.is_inline());
+
+    // Piąty odbiorca przenosi wagi i tablicę aliasów na stertę.
+    Storehouse s5(5);
+    rp.add_receiver(&s5);
+    EXPECT_NE(rp.choose_receiver(), nullptr);
+    EXPECT_FALSE(rp.is_inline());
+}
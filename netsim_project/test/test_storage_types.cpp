@@ -4,6 +4,15 @@
 #include "package.hpp"
 #include "storage_types.hpp"
 #include "types.hpp"
+#include "simulation_context.hpp"
+#include "nodes.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+#include <random>
+#include <set>
+#include <thread>
 
 using ::std::cout;
 using ::std::endl;
@@ -31,3 +40,388 @@ TEST(PackageQueueTest, IsLifoCorrect) {
     p = q.pop();
     EXPECT_EQ(p.get_id(), 1);
 }
+
+TEST(PackageQueueTest, IsPopNotAllocatingId) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+
+    PackageQueue q(PackageQueueType::FIFO);
+    q.push(Package());
+    q.push(Package());
+
+    Package p = q.pop();
+    EXPECT_EQ(p.get_id(), 1);
+    EXPECT_EQ(context.packages().size(), 2U);
+}
+
+TEST(PackageQueueTest, IsFifoCorrectAfterWrapAndGrowth) {
+    // Przesunięcie początku bufora, a następnie powiększenie go przy zawiniętej zawartości.
+    PackageQueue q(PackageQueueType::FIFO);
+    for (ElementID id = 1; id <= 10; ++id) {
+        q.push(Package(id));
+    }
+    for (ElementID id = 1; id <= 8; ++id) {
+        EXPECT_EQ(q.pop().get_id(), id);
+    }
+    for (ElementID id = 11; id <= 40; ++id) {
+        q.push(Package(id));
+    }
+
+    ASSERT_EQ(q.size(), 32U);
+    ElementID expected = 9;
+    for (auto it = q.cbegin(); it != q.cend(); ++it) {
+        EXPECT_EQ(it->get_id(), expected++);
+    }
+    for (ElementID id = 9; id <= 40; ++id) {
+        EXPECT_EQ(q.pop().get_id(), id);
+    }
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(PackageQueueTest, IsLifoCorrectAfterWrap) {
+    PackageQueue q(PackageQueueType::LIFO);
+    for (ElementID id = 1; id <= 20; ++id) {
+        q.push(Package(id));
+    }
+    for (ElementID id = 20; id > 5; --id) {
+        EXPECT_EQ(q.pop().get_id(), id);
+    }
+    q.push(Package(100));
+
+    EXPECT_EQ(q.pop().get_id(), 100);
+    EXPECT_EQ(q.pop().get_id(), 5);
+    EXPECT_EQ(q.size(), 4U);
+}
+
+TEST(PackageQueueTest, IsDestructorReleasingQueuedIds) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+    {
+        PackageQueue q(PackageQueueType::FIFO);
+        for (int i = 0; i < 20; ++i) {
+            q.push(Package());
+        }
+        EXPECT_EQ(context.packages().size(), 20U);
+    }
+    EXPECT_EQ(context.packages().size(), 0U);
+}
+
+namespace {
+    // Najprostszy magazyn spoza biblioteki -- iteracja ma działać bez znajomości jego kontenera.
+    class VectorStockpile : public IPackageStockpile {
+    public:
+        void push(Package&& package) override { ids_.push_back(package.release_handle()); }
+
+        std::size_t read(std::size_t position, PackageView* out, std::size_t count) const override {
+            std::size_t n = 0;
+            for (; n < count && position + n < ids_.size(); ++n) {
+                out[n] = PackageView(ids_[position + n]);
+            }
+            return n;
+        }
+
+        std::size_t size() const override { return ids_.size(); }
+        bool empty() const override { return ids_.empty(); }
+
+    private:
+        std::vector<ElementID> ids_;
+    };
+}
+
+TEST(PackageStockpileTest, IsIterationContainerAgnostic) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+
+    VectorStockpile stockpile;
+    EXPECT_EQ(stockpile.cbegin(), stockpile.cend());
+
+    for (ElementID id = 1; id <= 50; ++id) {
+        stockpile.push(Package(id));
+    }
+
+    std::vector<ElementID> ids;
+    for (const auto& p : stockpile) {
+        ids.push_back(p.get_id());
+    }
+    ASSERT_EQ(ids.size(), 50U);
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        EXPECT_EQ(ids[i], ElementID(i + 1));
+    }
+    EXPECT_EQ(std::next(stockpile.cbegin(), 50), stockpile.cend());
+    EXPECT_EQ(std::next(stockpile.cbegin(), 17)->get_id(), 18);
+
+    // Widok odczytany przed doczytaniem kolejnej porcji pozostaje ważny.
+    static_assert(std::is_same_v<std::iterator_traits<IPackageStockpile::const_iterator>::iterator_category,
+                                 std::input_iterator_tag>);
+    auto it = stockpile.cbegin();
+    PackageView first = *it;
+    std::advance(it, 40);
+    EXPECT_EQ(first.get_id(), 1);
+    EXPECT_EQ(it->get_id(), 41);
+}
+
+TEST(PriorityPackageQueueTest, IsOldestPackageFirst) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+
+    PriorityPackageQueue q;
+    ASSERT_TRUE(context.packages().is_enabled(PackageAttribute::CREATION_TURN));
+
+    Time turns[] = {5, 2, 9, 2, 1};
+    for (Time t : turns) {
+        Package p;
+        context.packages().record_origin(p.get_id(), t, 1);
+        q.push(std::move(p));
+    }
+
+    // Remis (tura 2) rozstrzyga mniejsze ID.
+    EXPECT_EQ(q.pop().get_id(), 5);
+    EXPECT_EQ(q.pop().get_id(), 2);
+    EXPECT_EQ(q.pop().get_id(), 4);
+    EXPECT_EQ(q.pop().get_id(), 1);
+    EXPECT_EQ(q.pop().get_id(), 3);
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(PriorityPackageQueueTest, IsHeapOrderKeptUnderInterleavedOperations) {
+    SimulationContext context(3);
+    SimulationContext::Scope scope(context);
+
+    PriorityPackageQueue q(PackageAttribute::HOP_COUNT);
+    std::multiset<std::pair<std::uint32_t, ElementID>> expected;
+    std::uniform_int_distribution<std::uint32_t> hops(0, 50);
+
+    for (int round = 0; round < 2000; ++round) {
+        if (round % 3 != 2) {
+            Package p;
+            auto h = hops(context.rng());
+            for (std::uint32_t i = 0; i < h; ++i) {
+                context.packages().count_hop(p.get_id());
+            }
+            expected.insert({h, p.get_id()});
+            q.push(std::move(p));
+        } else {
+            ASSERT_EQ(q.pop().get_id(), expected.begin()->second);
+            expected.erase(expected.begin());
+        }
+    }
+    EXPECT_EQ(q.size(), expected.size());
+
+    // Iteracja zwraca kopiec w kolejności tablicy, `in_pop_order()` -- w kolejności wyjmowania.
+    std::multiset<ElementID> iterated;
+    for (const auto& view : q) {
+        iterated.insert(view.get_id());
+    }
+    std::vector<ElementID> pop_order;
+    for (const auto& view : q.in_pop_order()) {
+        pop_order.push_back(view.get_id());
+    }
+    std::vector<ElementID> expected_order;
+    for (const auto& entry : expected) {
+        expected_order.push_back(entry.second);
+    }
+    EXPECT_EQ(pop_order, expected_order);
+    EXPECT_EQ(iterated, std::multiset<ElementID>(expected_order.begin(), expected_order.end()));
+
+    while (!q.empty()) {
+        ASSERT_EQ(q.pop().get_id(), expected.begin()->second);
+        expected.erase(expected.begin());
+    }
+}
+
+TEST(PriorityPackageQueueTest, IsDestructorReleasingQueuedIds) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+    {
+        PriorityPackageQueue q;
+        q.push(Package());
+        q.push(Package());
+    }
+    EXPECT_EQ(context.packages().size(), 0U);
+}
+
+TEST(BitmapStockpileTest, IsIterationSorted) {
+    SimulationContext context(5);
+    SimulationContext::Scope scope(context);
+
+    BitmapStockpile stockpile;
+    std::set<ElementID> expected;
+    std::uniform_int_distribution<ElementID> ids(1, 300000);
+    for (int i = 0; i < 20000; ++i) {
+        ElementID id = ids(context.rng());
+        if (expected.insert(id).second) {
+            stockpile.push(Package(id));
+        }
+    }
+
+    EXPECT_TRUE(stockpile.is_sorted());
+    ASSERT_EQ(stockpile.size(), expected.size());
+    EXPECT_TRUE(std::equal(stockpile.cbegin(), stockpile.cend(), expected.cbegin(),
+                           [](const PackageView& p, ElementID id) { return p.get_id() == id; }));
+}
+
+TEST(BitmapStockpileTest, AreConcurrentIterationsIndependent) {
+    SimulationContext context(7);
+    SimulationContext::Scope scope(context);
+
+    BitmapStockpile stockpile;
+    std::vector<ElementID> expected;
+    for (ElementID id = 1; id < 400000; id += 37) {
+        stockpile.push(Package(id));
+        expected.push_back(id);
+    }
+
+    // Każdy iterator ma własny kursor -- przeplatane i współbieżne przejścia nie przeszkadzają sobie.
+    auto first = stockpile.cbegin();
+    auto second = stockpile.cbegin();
+    for (std::size_t i = 0; i < 5000; ++i) {
+        ++second;
+    }
+    for (std::size_t i = 0; i < 5000; ++i, ++first, ++second) {
+        ASSERT_EQ((*first).get_id(), expected[i]);
+        ASSERT_EQ((*second).get_id(), expected[i + 5000]);
+    }
+
+    bool equal[2] = {false, false};
+    std::thread threads[2];
+    for (int t = 0; t < 2; ++t) {
+        threads[t] = std::thread([&stockpile, &expected, &equal, t]() {
+            equal[t] = true;
+            for (int round = 0; round < 5; ++round) {
+                equal[t] = equal[t] && std::equal(stockpile.cbegin(), stockpile.cend(), expected.cbegin(),
+                                                  [](const PackageView& p, ElementID id) { return p.get_id() == id; });
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_TRUE(equal[0]);
+    EXPECT_TRUE(equal[1]);
+}
+
+TEST(BitmapStockpileTest, IsDenseContainerConvertedToBitmap) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+
+    BitmapStockpile stockpile;
+    const std::size_t n = 100000;
+    for (std::size_t i = 0; i < n; ++i) {
+        stockpile.push(Package());
+    }
+
+    ASSERT_EQ(stockpile.size(), n);
+    // Lista: co najmniej 24 B na półprodukt; mapa bitowa: ok. 1 bit.
+    EXPECT_LT(stockpile.bytes_used(), n * 24 / 100);
+
+    ElementID expected = 1;
+    for (const auto& p : stockpile) {
+        ASSERT_EQ(p.get_id(), expected++);
+    }
+    EXPECT_EQ(std::next(stockpile.cbegin(), 70000)->get_id(), 70001);
+}
+
+TEST(BitmapStockpileTest, IsDestructorReleasingIds) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+    {
+        BitmapStockpile stockpile;
+        for (int i = 0; i < 5000; ++i) {
+            stockpile.push(Package());
+        }
+        EXPECT_EQ(context.packages().size(), 5000U);
+    }
+    EXPECT_EQ(context.packages().size(), 0U);
+}
+
+TEST(BitmapStockpileTest, IsDuplicateIdRejectedWithoutLeak) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+    {
+        BitmapStockpile stockpile;
+        stockpile.push(Package(5));
+        // Drugi uchwyt tego samego ID -- sytuacja niemożliwa przy poprawnym przydziale ID.
+        Package duplicate = Package::adopt_handle(5);
+        EXPECT_THROW(stockpile.push(std::move(duplicate)), std::logic_error);
+        EXPECT_EQ(duplicate.get_id(), 5);
+        EXPECT_EQ(stockpile.size(), 1U);
+        duplicate.release_handle();
+    }
+    EXPECT_EQ(context.packages().size(), 0U);
+}
+
+TEST(LogStockpileTest, IsSpilledLogIteratedInOrder) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+
+    LogStockpile stockpile(::testing::TempDir(), 8);
+    const ElementID n = 1000;
+    for (ElementID i = 0; i < n; ++i) {
+        stockpile.push(Package());
+        if (i == n / 2) {
+            // Odczyt w trakcie dopisywania -- mapowanie musi nadążać za plikiem.
+            EXPECT_EQ(std::next(stockpile.cbegin(), 100)->get_id(), 101);
+        }
+    }
+
+    ASSERT_EQ(stockpile.size(), std::size_t(n));
+    EXPECT_GE(stockpile.spilled_size(), std::size_t(n) - 8);
+
+    ElementID expected = 1;
+    for (const auto& p : stockpile) {
+        ASSERT_EQ(p.get_id(), expected++);
+    }
+    EXPECT_EQ(expected, n + 1);
+    EXPECT_EQ(context.packages().size(), std::size_t(n));
+}
+
+TEST(LogStockpileTest, IsDestructorReleasingIdsAndRemovingLog) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+    std::string path;
+    {
+        LogStockpile stockpile(::testing::TempDir(), 4);
+        for (int i = 0; i < 10; ++i) {
+            stockpile.push(Package());
+        }
+        path = stockpile.get_path();
+        EXPECT_TRUE(std::ifstream(path).good());
+    }
+    EXPECT_EQ(context.packages().size(), 0U);
+    EXPECT_FALSE(std::ifstream(path).good());
+}
+
+TEST(LogStockpileTest, IsDestructorStoppingAtUnreadableLog) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+    std::string path;
+    {
+        LogStockpile stockpile(::testing::TempDir(), 4);
+        for (int i = 0; i < 10; ++i) {
+            stockpile.push(Package());
+        }
+        ASSERT_EQ(stockpile.spilled_size(), 8U);
+        path = stockpile.get_path();
+        // Plik ucięty po trzech ID -- destruktor zwalnia, co zdoła odczytać, i nie rzuca.
+        std::filesystem::resize_file(path, 3 * sizeof(ElementID));
+    }
+    EXPECT_EQ(context.packages().size(), 5U);
+    EXPECT_FALSE(std::ifstream(path).good());
+}
+
+TEST(LogStockpileTest, IsContextDefaultUsedByStorehouse) {
+    SimulationContext context;
+    SimulationContext::Scope scope(context);
+    context.stockpile_options().type = StockpileType::LOG;
+    context.stockpile_options().spill_directory = ::testing::TempDir();
+
+    Storehouse s(1);
+    EXPECT_NE(dynamic_cast<const LogStockpile*>(&s.get_stockpile()), nullptr);
+    EXPECT_FALSE(s.get_stockpile_type().has_value());
+}
+
+TEST(LogStockpileTest, IsSystemTempDirectoryUsedByDefault) {
+    auto stockpile = make_stockpile(StockpileType::LOG, StockpileOptions());
+    auto& log = dynamic_cast<const LogStockpile&>(*stockpile);
+    EXPECT_EQ(std::filesystem::path(log.get_path()).parent_path(), std::filesystem::temp_directory_path());
+}